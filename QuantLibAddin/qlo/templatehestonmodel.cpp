@@ -7,12 +7,368 @@
 
 
 #include <qlo/templatehestonmodel.hpp>
+#include <qlo/templatememocache.hpp>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/timer.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <algorithm>
+#include <complex>
+#include <list>
+#include <map>
+
+#include <ql/exercise.hpp>
+#include <ql/instruments/vanillaoption.hpp>
+#include <ql/math/integrals/gaussianquadratures.hpp>
+#include <ql/math/matrixutilities/choleskydecomposition.hpp>
+#include <ql/math/matrixutilities/symmetricschurdecomposition.hpp>
+#include <ql/math/rounding.hpp>
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/pricingengines/genericmodelengine.hpp>
+#include <ql/settings.hpp>
+#include <ql/termstructures/volatility/equityfx/blackvariancesurface.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
 
 
 namespace QuantLibAddin {
 
+	namespace {
+
+		typedef std::complex<QuantLib::Real> Complex;
+
+		// characteristic function of log(S_T / F) at u and u - i for all Gauss-Laguerre nodes u,
+		// in the formulation without branch cut discontinuity
+		void hestonCharacteristicNodes(const QuantLib::HestonModel& model, const QuantLib::Time term, const QuantLib::Array& nodes,
+			                           std::vector<Complex>& phi, std::vector<Complex>& phiShifted) {
+			const QuantLib::Real kappa = model.kappa(), theta = model.theta(), sigma = model.sigma(), rho = model.rho(), v0 = model.v0();
+			phi.resize(nodes.size());
+			phiShifted.resize(nodes.size());
+			for (QuantLib::Size j = 0; j < nodes.size(); ++j) {
+				for (QuantLib::Size s = 0; s < 2; ++s) {
+					Complex u(nodes[j], (s == 0) ? 0.0 : -1.0);
+					Complex iu = Complex(0.0, 1.0) * u;
+					Complex beta = kappa - rho * sigma * iu;
+					Complex d = std::sqrt(beta * beta + sigma * sigma * (iu + u * u));
+					Complex g = (beta - d) / (beta + d);
+					Complex edT = std::exp(-d * term);
+					Complex C = kappa * theta / sigma / sigma * ((beta - d) * term - 2.0 * std::log((1.0 - g * edT) / (1.0 - g)));
+					Complex D = (beta - d) / sigma / sigma * (1.0 - edT) / (1.0 - g * edT);
+					((s == 0) ? phi : phiShifted)[j] = std::exp(C + D * v0);
+				}
+			}
+		}
+
+		// undiscounted call price from characteristic function node values; each strike only
+		// adds the Fourier factor exp(-i u k)
+		QuantLib::Real hestonUndiscountedCall(const QuantLib::Real forward, const QuantLib::Real strike, const QuantLib::GaussLaguerreIntegration& integration,
+			                                  const std::vector<Complex>& phi, const std::vector<Complex>& phiShifted) {
+			const QuantLib::Array& nodes = integration.x();
+			const QuantLib::Array& weights = integration.weights();
+			QuantLib::Real logMoneyness = std::log(strike / forward);
+			QuantLib::Real integral = 0.0;
+			for (QuantLib::Size j = 0; j < nodes.size(); ++j) {
+				Complex iu(0.0, nodes[j]);
+				integral += weights[j] * (std::exp(-iu * logMoneyness) * (forward * phiShifted[j] - strike * phi[j]) / iu).real();
+			}
+			return 0.5 * (forward - strike) + integral / M_PI;
+		}
+
+		// European vanilla engine on a fixed Gauss-Laguerre node set; characteristic function values
+		// are kept per expiry for the current model parameters, such that calibration helpers of the
+		// same expiry price their strip with one characteristic function evaluation per parameter set
+		class HestonStripEngine : public QuantLib::GenericModelEngine<QuantLib::HestonModel,
+			                                                          QuantLib::VanillaOption::arguments,
+			                                                          QuantLib::VanillaOption::results> {
+		public:
+			HestonStripEngine(const boost::shared_ptr<QuantLib::HestonModel>& model, const QuantLib::Size integrationOrder)
+				: QuantLib::GenericModelEngine<QuantLib::HestonModel, QuantLib::VanillaOption::arguments, QuantLib::VanillaOption::results>(model),
+				  integration_(integrationOrder) {}
+			void calculate() const {
+				QL_REQUIRE(arguments_.exercise->type() == QuantLib::Exercise::European, "HestonStripEngine: European exercise required");
+				boost::shared_ptr<QuantLib::StrikedTypePayoff> payoff = boost::dynamic_pointer_cast<QuantLib::StrikedTypePayoff>(arguments_.payoff);
+				QL_REQUIRE(payoff, "HestonStripEngine: striked payoff required");
+				const boost::shared_ptr<QuantLib::HestonProcess>& process = model_->process();
+				QuantLib::Time term = process->time(arguments_.exercise->lastDate());
+				QL_REQUIRE(term > 0.0, "HestonStripEngine: positive time to expiry required");
+				QuantLib::DiscountFactor df = process->riskFreeRate()->discount(term);
+				QuantLib::Real forward = process->s0()->value() * process->dividendYield()->discount(term) / df;
+				QuantLib::Real strike = payoff->strike();
+				const Strip& strip = characteristicStrip(term);
+				QuantLib::Real call = hestonUndiscountedCall(forward, strike, integration_, strip.first, strip.second);
+				results_.value = df * ((payoff->optionType() == QuantLib::Option::Call) ? call : call - (forward - strike));
+			}
+		private:
+			typedef std::pair< std::vector<Complex>, std::vector<Complex> > Strip;  // (phi, phiShifted)
+			const Strip& characteristicStrip(const QuantLib::Time term) const {
+				QuantLib::Array params = model_->params();
+				if (params.size() != params_.size() || !std::equal(params.begin(), params.end(), params_.begin())) {
+					strips_.clear();
+					params_ = params;
+				}
+				std::map<QuantLib::Time, Strip>::iterator it = strips_.find(term);
+				if (it == strips_.end()) {
+					it = strips_.insert(std::make_pair(term, Strip())).first;
+					hestonCharacteristicNodes(*model_.currentLink(), term, integration_.x(), it->second.first, it->second.second);
+				}
+				return it->second;
+			}
+			QuantLib::GaussLaguerreIntegration        integration_;
+			mutable QuantLib::Array                   params_;
+			mutable std::map<QuantLib::Time, Strip>   strips_;
+		};
+
+		// leverage function pre-sampled on a uniform (t, log S) grid; cells are found in constant
+		// time and values are interpolated bilinearly, outside the grid they are extrapolated flat.
+		// The table is re-sampled when the source leverage function notifies a change
+		class UniformLeverageTable : public QuantLib::LocalVolTermStructure {
+		public:
+			UniformLeverageTable(const boost::shared_ptr<QuantLib::LocalVolTermStructure>&  source,
+				                 const QuantLib::Size                                       timeSteps,
+				                 const QuantLib::Size                                       logStrikeSteps,
+				                 const QuantLib::Real                                       minStrike,
+				                 const QuantLib::Real                                       maxStrike)
+				: source_(source), nT_(timeSteps + 1), nX_(logStrikeSteps + 1) {
+				QL_REQUIRE(timeSteps > 0 && logStrikeSteps > 0, "UniformLeverageTable: positive number of steps required");
+				QL_REQUIRE(minStrike > 0.0 && minStrike < maxStrike, "UniformLeverageTable: 0 < minStrike < maxStrike required");
+				x0_ = std::log(minStrike);
+				x1_ = std::log(maxStrike);
+				registerWith(source_);
+				sample();
+			}
+			// TermStructure interface, dates and times follow the source
+			const QuantLib::Date& referenceDate() const { return source_->referenceDate(); }
+			QuantLib::DayCounter dayCounter() const { return source_->dayCounter(); }
+			QuantLib::Calendar calendar() const { return source_->calendar(); }
+			QuantLib::Natural settlementDays() const { return source_->settlementDays(); }
+			QuantLib::Date maxDate() const { return source_->maxDate(); }
+			// VolatilityTermStructure interface
+			QuantLib::Real minStrike() const { return std::exp(x0_); }
+			QuantLib::Real maxStrike() const { return std::exp(x1_); }
+			// Observer interface
+			void update() {
+				sample();
+				QuantLib::LocalVolTermStructure::update();
+			}
+		protected:
+			QuantLib::Volatility localVolImpl(QuantLib::Time t, QuantLib::Real strike) const {
+				QuantLib::Real s = std::min(std::max(t * invDt_, 0.0), (QuantLib::Real)(nT_ - 1));
+				QuantLib::Real u = (strike > 0.0) ? std::min(std::max((std::log(strike) - x0_) * invDx_, 0.0), (QuantLib::Real)(nX_ - 1)) : 0.0;
+				QuantLib::Size i = std::min((QuantLib::Size)s, nT_ - 2), j = std::min((QuantLib::Size)u, nX_ - 2);
+				s -= i;
+				u -= j;
+				const QuantLib::Real* v = &values_[i * nX_ + j];
+				return (1.0 - s) * ((1.0 - u) * v[0] + u * v[1]) + s * ((1.0 - u) * v[nX_] + u * v[nX_ + 1]);
+			}
+		private:
+			void sample() {
+				QuantLib::Time tMax = source_->maxTime();
+				QL_REQUIRE(tMax > 0.0, "UniformLeverageTable: leverage function with positive maximum time required");
+				invDt_ = (nT_ - 1) / tMax;
+				invDx_ = (nX_ - 1) / (x1_ - x0_);
+				values_.resize(nT_ * nX_);
+				for (QuantLib::Size i = 0; i < nT_; ++i)
+					for (QuantLib::Size j = 0; j < nX_; ++j)
+						values_[i * nX_ + j] = source_->localVol(i / invDt_, std::exp(x0_ + j / invDx_), true);
+			}
+			boost::shared_ptr<QuantLib::LocalVolTermStructure>  source_;
+			QuantLib::Size                                      nT_, nX_;
+			QuantLib::Real                                      x0_, x1_, invDt_, invDx_;
+			std::vector<QuantLib::Real>                         values_;  // contiguous rows in log strike per time
+		};
+
+		// tables are shared by all processes built from the same leverage function and grid; an
+		// entry is guarded by its table and expires with the last process using it
+		typedef std::pair<const QuantLib::LocalVolTermStructure*, std::vector<QuantLib::Real> > LeverageTableKey;
+		typedef MemoCache< LeverageTableKey, boost::weak_ptr<QuantLib::LocalVolTermStructure> > LeverageTableCache;
+
+		LeverageTableCache& leverageTableCache() {
+			static LeverageTableCache cache;
+			return cache;
+		}
+
+		boost::shared_ptr<QuantLib::LocalVolTermStructure> leverageTable(
+			const boost::shared_ptr<QuantLib::LocalVolTermStructure>&  leverageFct,
+			const QuantLib::Size                                       timeSteps,
+			const QuantLib::Size                                       logStrikeSteps,
+			const QuantLib::Real                                       minStrike,
+			const QuantLib::Real                                       maxStrike) {
+			std::vector<QuantLib::Real> grid(4);
+			grid[0] = (QuantLib::Real)timeSteps;
+			grid[1] = (QuantLib::Real)logStrikeSteps;
+			grid[2] = minStrike;
+			grid[3] = maxStrike;
+			LeverageTableKey key(leverageFct.get(), grid);
+			const boost::weak_ptr<QuantLib::LocalVolTermStructure>* cached = leverageTableCache().find(key);
+			if (cached) return cached->lock();
+			boost::shared_ptr<QuantLib::LocalVolTermStructure> table(
+				new UniformLeverageTable(leverageFct, timeSteps, logStrikeSteps, minStrike, maxStrike));
+			leverageTableCache().insert(key, table, table);
+			return table;
+		}
+
+		// time-homogeneous models with parameters averaged up to expiry, memoized by model
+		// object and expiry; model parameters are fixed at construction. An entry is guarded
+		// by its model without keeping it alive and expires once the model is destroyed
+		typedef std::pair<const QuantLib::RealTDStochVolModel*, QuantLib::Time> AveragedStochVolModelKey;
+		typedef MemoCache< AveragedStochVolModelKey, boost::shared_ptr<QuantLib::RealStochVolModel> > AveragedStochVolModelCache;
+
+		AveragedStochVolModelCache& averagedStochVolModelCache() {
+			static AveragedStochVolModelCache cache;
+			return cache;
+		}
+
+		boost::shared_ptr<QuantLib::RealStochVolModel> averagedStochVolModel(
+			const boost::shared_ptr<QuantLib::RealTDStochVolModel>&  model,
+			const QuantLib::Time                                     term) {
+			AveragedStochVolModelKey key(model.get(), term);
+			AveragedStochVolModelCache& cache = averagedStochVolModelCache();
+			if (const boost::shared_ptr<QuantLib::RealStochVolModel>* cached = cache.find(key)) return *cached;
+			boost::shared_ptr<QuantLib::RealStochVolModel> averaged(new QuantLib::RealStochVolModel(
+				model->averageLambda(term), model->averageB(term), model->L(), model->theta(), model->m(),
+				model->averageEta(term), model->z0(), model->rho()));
+			cache.insert(key, averaged, model);
+			return averaged;
+		}
+
+		// repaired correlation matrices and their lower triangular factors; keys are the (symmetrised)
+		// matrix elements, or with positive quantum the rounded elements in units of the quantum
+		typedef std::pair<QuantLib::Real, std::vector<QuantLib::Real> > CorrelationDecompositionKey;
+		typedef std::pair<QuantLib::Matrix, QuantLib::Matrix> CorrelationDecompositionEntry;  // (correlation, factor)
+		typedef MemoCache<CorrelationDecompositionKey, CorrelationDecompositionEntry> CorrelationDecompositionCache;
+
+		CorrelationDecompositionCache& correlationDecompositionCache() {
+			static CorrelationDecompositionCache cache;
+			return cache;
+		}
+
+		// number of non-PD inputs repaired since the cache was last cleared
+		QuantLib::Size& correlationRepairs() {
+			static QuantLib::Size repairs = 0;
+			return repairs;
+		}
+
+		// smallest eigenvalue kept by the spectral repair such that the factor exists
+		const QuantLib::Real minCorrelationEigenvalue = 1.0e-8;
+
+		// implied volatilities of a Heston model on a (time, strike) grid, interpolated in variance;
+		// the grid is rebuilt lazily whenever the model changes, e.g. by calibration. Reference date
+		// and day counter follow the model's risk-free curve; grid times are mapped to dates of at
+		// least one day after the reference date, and volatilities are implied at the times the
+		// day counter assigns to these dates such that the surface reproduces the grid prices
+		class HestonGridBlackVolSurface : public QuantLib::LazyObject, public QuantLib::BlackVarianceTermStructure {
+		public:
+			HestonGridBlackVolSurface(
+				const QuantLib::Handle<QuantLib::HestonModel>&  model,
+				const std::vector<QuantLib::Time>&              times,
+				const std::vector<QuantLib::Real>&              strikes,
+				const QuantLib::Size                            integrationOrder)
+				: QuantLib::BlackVarianceTermStructure(QuantLib::Following, model->process()->riskFreeRate()->dayCounter()),
+				  model_(model), times_(times), strikes_(strikes), integrationOrder_(integrationOrder) {
+				QL_REQUIRE(times_.size() > 0 && strikes_.size() > 0, "Non-empty times and strikes required.");
+				for (QuantLib::Size k = 0; k < strikes_.size(); ++k)
+					QL_REQUIRE(strikes_[k] > 0.0 && (k == 0 || strikes_[k] > strikes_[k - 1]), "Positive ascending strikes required.");
+				for (QuantLib::Size i = 0; i < times_.size(); ++i)
+					QL_REQUIRE(times_[i] > 0.0 && (i == 0 || times_[i] > times_[i - 1]), "Positive ascending times required.");
+				registerWith(model_);
+				registerWith(QuantLib::Settings::instance().evaluationDate());
+			}
+			// TermStructure interface
+			const QuantLib::Date& referenceDate() const { return model_->process()->riskFreeRate()->referenceDate(); }
+			QuantLib::Calendar calendar() const { return QuantLib::NullCalendar(); }
+			QuantLib::Natural settlementDays() const { return model_->process()->riskFreeRate()->settlementDays(); }
+			QuantLib::Date maxDate() const {
+				calculate();
+				return dates_.back();
+			}
+			QuantLib::Real minStrike() const { return strikes_.front(); }
+			QuantLib::Real maxStrike() const { return strikes_.back(); }
+			void update() {
+				LazyObject::update();
+				BlackVarianceTermStructure::update();
+			}
+		protected:
+			QuantLib::Real blackVarianceImpl(QuantLib::Time t, QuantLib::Real strike) const {
+				calculate();
+				return surface_->blackVariance(t, strike, true);
+			}
+			void performCalculations() const {
+				const boost::shared_ptr<QuantLib::HestonProcess>& process = model_->process();
+				QuantLib::Date today = referenceDate();
+				// times closer than a day to the reference date are moved to the next day, times
+				// mapping to an already used date are dropped
+				dates_.clear();
+				std::vector<QuantLib::Time> times;
+				for (QuantLib::Size i = 0; i < times_.size(); ++i) {
+					QuantLib::Date date = std::max(today + ((QuantLib::BigInteger)QuantLib::ClosestRounding(0)(times_[i] * 365.0)), today + 1);
+					if (!dates_.empty() && date <= dates_.back()) continue;
+					dates_.push_back(date);
+					times.push_back(dayCounter().yearFraction(today, date));
+				}
+				std::vector<QuantLib::Real> forwards(times.size());
+				for (QuantLib::Size i = 0; i < times.size(); ++i)
+					forwards[i] = process->s0()->value() * process->dividendYield()->discount(times[i]) / process->riskFreeRate()->discount(times[i]);
+				// one characteristic function evaluation per term for all strikes, calls and puts
+				std::vector< std::vector<QuantLib::Real> > calls = hestonStripPrices(model_.currentLink(), forwards, times, strikes_, 1, integrationOrder_);
+				QuantLib::Matrix vols(strikes_.size(), times.size());
+				for (QuantLib::Size i = 0; i < times.size(); ++i) {
+					// invert out-of-the-money prices, puts via parity; prices outside the no-arbitrage
+					// bounds (quadrature noise in the far wings) take the vol of the nearest valid strike
+					std::vector<bool> valid(strikes_.size(), false);
+					for (QuantLib::Size k = 0; k < strikes_.size(); ++k) {
+						bool isCall = strikes_[k] >= forwards[i];
+						QuantLib::Real price = isCall ? calls[i][k] : calls[i][k] - (forwards[i] - strikes_[k]);
+						QuantLib::Real upper = isCall ? forwards[i] : strikes_[k];
+						if (!(price > QL_EPSILON * upper && price < upper)) continue;
+						QuantLib::Real stdDev = QuantLib::blackFormulaImpliedStdDev(isCall ? QuantLib::Option::Call : QuantLib::Option::Put,
+							strikes_[k], forwards[i], price, 1.0, 0.0, QuantLib::Null<QuantLib::Real>(), 1.0e-10, 100);
+						vols[k][i] = stdDev / std::sqrt(times[i]);
+						valid[k] = true;
+					}
+					for (QuantLib::Size k = 0; k < strikes_.size(); ++k) {
+						if (valid[k]) continue;
+						QuantLib::Size nearest = strikes_.size();
+						for (QuantLib::Size j = 0; j < strikes_.size(); ++j)
+							if (valid[j] && (nearest == strikes_.size() || std::fabs(strikes_[j] - strikes_[k]) < std::fabs(strikes_[nearest] - strikes_[k]))) nearest = j;
+						QL_REQUIRE(nearest < strikes_.size(), "No valid Heston price to invert at time " << times[i] << ".");
+						vols[k][i] = vols[nearest][i];
+					}
+				}
+				surface_ = boost::shared_ptr<QuantLib::BlackVarianceSurface>(new QuantLib::BlackVarianceSurface(
+					today, QuantLib::NullCalendar(), dates_, strikes_, vols, dayCounter()));
+			}
+			QuantLib::Handle<QuantLib::HestonModel>                     model_;
+			std::vector<QuantLib::Time>                                 times_;
+			std::vector<QuantLib::Real>                                 strikes_;
+			QuantLib::Size                                              integrationOrder_;
+			mutable std::vector<QuantLib::Date>                         dates_;
+			mutable boost::shared_ptr<QuantLib::BlackVarianceSurface>   surface_;
+		};
+
+		// the Fokker-Planck calibration is lazy; it is timed wherever leverageFunction() triggers it
+		class TimedHestonSLVFDMModel : public QuantLib::HestonSLVFDMModel {
+		public:
+			TimedHestonSLVFDMModel(
+				const QuantLib::Handle<QuantLib::LocalVolTermStructure>&    localVol,
+				const QuantLib::Handle<QuantLib::HestonModel>&              hestonModel,
+				const QuantLib::Date&                                       endDate,
+				const QuantLib::HestonSLVFokkerPlanckFdmParams&             params,
+				const bool                                                  logging,
+				const std::vector<QuantLib::Date>&                          mandatoryDates)
+				: QuantLib::HestonSLVFDMModel(localVol, hestonModel, endDate, params, logging, mandatoryDates), calibrationTime_(0.0) {}
+			QuantLib::Real calibrationTime() const { return calibrationTime_; }
+		protected:
+			void performCalculations() const {
+				boost::timer t;
+				QuantLib::HestonSLVFDMModel::performCalculations();
+				calibrationTime_ = t.elapsed();
+			}
+			mutable QuantLib::Real calibrationTime_;
+		};
+
+	}
+
     HestonProcess::HestonProcess(
             const boost::shared_ptr<ObjectHandler::ValueObject>& properties,
             const QuantLib::Handle<QuantLib::YieldTermStructure>& riskFreeRate,
@@ -42,20 +398,98 @@ namespace QuantLibAddin {
 		const std::vector<QuantLib::Real>&                                  weights,
 		const std::vector<bool>&                                            fixParameters,
 		const QuantLib::Real                                                hestonRelTolerance,
-	    const QuantLib::Size                                                hestonMaxEvaluations ) {
+	    const QuantLib::Size                                                hestonMaxEvaluations,
+		const QuantLib::Size                                                integrationOrder ) {
 		boost::shared_ptr<QuantLib::HestonModel> model = boost::dynamic_pointer_cast<QuantLib::HestonModel>(libraryObject_);
+		// on a fixed Gauss-Laguerre node set helpers of the same expiry share one characteristic
+		// function evaluation per parameter set instead of adaptive re-evaluation per helper
+		boost::shared_ptr<QuantLib::PricingEngine> engine = (integrationOrder > 0) ?
+			boost::shared_ptr<QuantLib::PricingEngine>(new HestonStripEngine(model, integrationOrder)) :
+			boost::shared_ptr<QuantLib::PricingEngine>(new QuantLib::AnalyticHestonEngine(model, hestonRelTolerance, hestonMaxEvaluations));
 		for (QuantLib::Size k = 0; k<instruments.size(); ++k) {
-			instruments[k]->setPricingEngine(boost::shared_ptr<QuantLib::PricingEngine>(new QuantLib::AnalyticHestonEngine(model, hestonRelTolerance, hestonMaxEvaluations)));
+			instruments[k]->setPricingEngine(engine);
 		}
 		model->calibrate(instruments, *method, *endCriteria, QuantLib::NoConstraint(), weights, fixParameters);
 	}
 
+	std::vector< std::vector<QuantLib::Real> > hestonStripPrices(
+		const boost::shared_ptr<QuantLib::HestonModel>&                     model,
+		const std::vector<QuantLib::Real>&                                  forwardPrices,
+		const std::vector<QuantLib::Time>&                                  terms,
+		const std::vector<QuantLib::Real>&                                  strikePrices,
+		const long                                                          callOrPut,
+		const QuantLib::Size                                                integrationOrder) {
+		QL_REQUIRE(forwardPrices.size() == terms.size(), "Forward prices and terms must be of equal size.");
+		QL_REQUIRE(callOrPut == 1 || callOrPut == -1, "Call (1) or Put (-1) option required.");
+		QL_REQUIRE(integrationOrder > 0, "Positive integration order required.");
+		for (QuantLib::Size k = 0; k < strikePrices.size(); ++k)
+			QL_REQUIRE(strikePrices[k] > 0.0, "Positive strike prices required.");
+		QuantLib::GaussLaguerreIntegration integration(integrationOrder);
+		std::vector< std::vector<QuantLib::Real> > res(terms.size(), std::vector<QuantLib::Real>(strikePrices.size(), 0.0));
+		std::vector<Complex> phi, phiShifted;
+		for (QuantLib::Size i = 0; i < terms.size(); ++i) {
+			QL_REQUIRE(terms[i] > 0.0, "Positive terms required.");
+			QL_REQUIRE(forwardPrices[i] > 0.0, "Positive forward prices required.");
+			// characteristic function once per term for all strikes
+			hestonCharacteristicNodes(*model, terms[i], integration.x(), phi, phiShifted);
+			for (QuantLib::Size k = 0; k < strikePrices.size(); ++k) {
+				QuantLib::Real F = forwardPrices[i], K = strikePrices[k];
+				QuantLib::Real call = hestonUndiscountedCall(F, K, integration, phi, phiShifted);
+				res[i][k] = (callOrPut == 1) ? call : call - (F - K);
+			}
+		}
+		return res;
+	}
+
+	std::vector<QuantLib::Real> realTDStochVolModelVanillaOptions(
+		const boost::shared_ptr<QuantLib::RealTDStochVolModel>&             model,
+		const QuantLib::Real                                                forwardPrice,
+		const std::vector<QuantLib::Real>&                                  strikePrices,
+		const QuantLib::Time                                                term,
+		const long                                                          callOrPut,
+		const QuantLib::Real                                                accuracy,
+		const long                                                          maxEvaluations) {
+		// one parameter averaging per expiry, strikes only re-run the pricing integral
+		boost::shared_ptr<QuantLib::RealStochVolModel> averaged = averagedStochVolModel(model, term);
+		std::vector<QuantLib::Real> res(strikePrices.size());
+		for (QuantLib::Size k = 0; k < strikePrices.size(); ++k)
+			res[k] = averaged->vanillaOption(forwardPrice, strikePrices[k], term, callOrPut, accuracy, maxEvaluations);
+		return res;
+	}
+
+	std::vector<QuantLib::Real> realTDStochVolModelAveragedCacheInfo() {
+		return averagedStochVolModelCache().info();
+	}
+
+	QuantLib::Size realTDStochVolModelAveragedClearCache() {
+		return averagedStochVolModelCache().clear();
+	}
+
 	HestonSLVProcess::HestonSLVProcess(const boost::shared_ptr<ObjectHandler::ValueObject>& properties,
 		const boost::shared_ptr<QuantLib::HestonProcess>& hestonProcess,
 		const boost::shared_ptr<QuantLib::LocalVolTermStructure>& leverageFct,
+		const QuantLib::Size tableTimeSteps,
+		const QuantLib::Size tableLogStrikeSteps,
+		const QuantLib::Real tableMinStrike,
+		const QuantLib::Real tableMaxStrike,
 		bool permanent) : StochasticProcess(properties,permanent) {
+		boost::shared_ptr<QuantLib::LocalVolTermStructure> leverage = leverageFct;
+		if (tableTimeSteps > 0 || tableLogStrikeSteps > 0) {
+			// strike range defaults to the domain of the leverage function
+			QuantLib::Real minStrike = (tableMinStrike > 0.0) ? tableMinStrike : leverageFct->minStrike();
+			QuantLib::Real maxStrike = (tableMaxStrike > 0.0) ? tableMaxStrike : leverageFct->maxStrike();
+			leverage = leverageTable(leverageFct, tableTimeSteps, tableLogStrikeSteps, minStrike, maxStrike);
+		}
 		libraryObject_ = boost::shared_ptr<QuantLib::HestonSLVProcess>(
-			new QuantLib::HestonSLVProcess(hestonProcess,leverageFct));
+			new QuantLib::HestonSLVProcess(hestonProcess,leverage));
+	}
+
+	std::vector<QuantLib::Real> hestonSLVLeverageTableCacheInfo() {
+		return leverageTableCache().info();
+	}
+
+	QuantLib::Size hestonSLVLeverageTableClearCache() {
+		return leverageTableCache().clear();
 	}
 
     AnalyticHestonEngine::AnalyticHestonEngine(
@@ -92,6 +526,17 @@ namespace QuantLibAddin {
 		libraryObject_ = boost::shared_ptr<QuantLib::BlackVolTermStructure>(new QuantLib::HestonBlackVolSurface(model));
 	}
 
+	HestonBlackVolSurface::HestonBlackVolSurface(
+		const boost::shared_ptr<ObjectHandler::ValueObject>&    properties,
+		const QuantLib::Handle<QuantLib::HestonModel>&          model,
+		const std::vector<QuantLib::Time>&                      times,
+		const std::vector<QuantLib::Real>&                      strikes,
+		const QuantLib::Size                                    integrationOrder,
+		bool                                                    permanent)
+		: BlackVolTermStructure(properties, permanent) {
+		libraryObject_ = boost::shared_ptr<QuantLib::BlackVolTermStructure>(new HestonGridBlackVolSurface(model, times, strikes, integrationOrder));
+	}
+
 
     RealHestonModel::RealHestonModel(
                 const boost::shared_ptr<ObjectHandler::ValueObject>& properties,
@@ -219,6 +664,52 @@ namespace QuantLibAddin {
 				 z0IsFixed,rhoIsFixed,exercTime,forward,strikes,vols,optimizationParams));
 	}
 
+	std::vector< std::vector<QuantLib::Real> > stochVolModelCalibrateSmiles(
+		        const std::vector<QuantLib::Real>&                   initialParams,
+		        const std::vector<bool>&                             isFixed,
+		        const std::vector<QuantLib::Real>&                   exercTimes,
+		        const std::vector<QuantLib::Real>&                   forwards,
+		        const std::vector< std::vector<QuantLib::Real> >&    strikes,
+		        const std::vector< std::vector<QuantLib::Real> >&    vols,
+				const std::vector<QuantLib::Real>&                   optimizationParams,
+				const bool                                           warmStart) {
+		QL_REQUIRE(initialParams.size() == 8, "Eight initial parameters required.");
+		QL_REQUIRE(isFixed.size() == 8, "Eight calibration flags required.");
+		QL_REQUIRE(forwards.size() == exercTimes.size() && strikes.size() == exercTimes.size() && vols.size() == exercTimes.size(),
+			"Exercise times, forwards, strikes and vols must be of equal size.");
+		QL_REQUIRE(optimizationParams.size() >= 2, "Optimization params must end with glAbsAcc and glMaxEval.");
+		QuantLib::Real glAbsAcc = optimizationParams[optimizationParams.size() - 2];
+		QuantLib::Size glMaxEval = (QuantLib::Size)optimizationParams.back();
+		std::vector<QuantLib::Real> p(initialParams);
+		std::vector< std::vector<QuantLib::Real> > res;
+		for (QuantLib::Size i = 0; i < exercTimes.size(); ++i) {
+			if (!warmStart) p = initialParams;
+			boost::timer t;
+			QuantLib::StochVolModelCalibrator calibrator(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+				isFixed[0], isFixed[1], isFixed[2], isFixed[3], isFixed[4], isFixed[5], isFixed[6], isFixed[7],
+				exercTimes[i], forwards[i], strikes[i], vols[i], optimizationParams);
+			QuantLib::Real seconds = t.elapsed();
+			QuantLib::Real calibrated[] = { calibrator.lambda(), calibrator.b(), calibrator.L(), calibrator.theta(),
+				calibrator.m(), calibrator.eta(), calibrator.z0(), calibrator.rho() };
+			p = std::vector<QuantLib::Real>(calibrated, calibrated + 8);
+			// diagnostics in terms of normal volatilities as quoted in the targets
+			QuantLib::RealStochVolModel model(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
+			QuantLib::Real sum = 0.0;
+			for (QuantLib::Size k = 0; k < strikes[i].size(); ++k) {
+				long callOrPut = (strikes[i][k] >= forwards[i]) ? 1 : -1;
+				QuantLib::Real price = model.vanillaOption(forwards[i], strikes[i][k], exercTimes[i], callOrPut, glAbsAcc, glMaxEval);
+				QuantLib::Real vol = QuantLib::bachelierBlackFormulaImpliedVol((callOrPut == 1) ? QuantLib::Option::Call : QuantLib::Option::Put,
+					strikes[i][k], forwards[i], exercTimes[i], price);
+				sum += (vol - vols[i][k]) * (vol - vols[i][k]);
+			}
+			std::vector<QuantLib::Real> row(p);
+			row.push_back((strikes[i].size() > 0) ? std::sqrt(sum / strikes[i].size()) : 0.0);
+			row.push_back(seconds);
+			res.push_back(row);
+		}
+		return res;
+	}
+
 	HestonSLVFokkerPlanckFdmParams::HestonSLVFokkerPlanckFdmParams(
 		const boost::shared_ptr<ObjectHandler::ValueObject>&  properties,
 		const QuantLib::Size                                  xGrid,
@@ -331,7 +822,26 @@ namespace QuantLibAddin {
 		bool                                                                permanent)
 		: ObjectHandler::LibraryObject<QuantLib::HestonSLVFDMModel>(properties, permanent) {
 		libraryObject_ = boost::shared_ptr<QuantLib::HestonSLVFDMModel>(
-			new QuantLib::HestonSLVFDMModel(localVol, hestonModel, endDate, *params, logging, mandatoryDates));
+			new TimedHestonSLVFDMModel(localVol, hestonModel, endDate, *params, logging, mandatoryDates));
+	}
+
+	QuantLib::Real HestonSLVFDMModel::calibrationTime() const {
+		return boost::static_pointer_cast<TimedHestonSLVFDMModel>(libraryObject_)->calibrationTime();
+	}
+
+	std::vector< std::vector<QuantLib::Real> > HestonSLVFDMModel::logTable() const {
+		// the log is filled by the lazy leverage function calibration, trigger it first
+		libraryObject_->calculate();
+		const std::list<QuantLib::HestonSLVFDMModel::LogEntry>& entries = libraryObject_->logEntries();
+		QL_REQUIRE(entries.size() > 0, "Log requires model constructed with logging.");
+		std::vector< std::vector<QuantLib::Real> > res;
+		for (std::list<QuantLib::HestonSLVFDMModel::LogEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+			std::vector<QuantLib::Real> row(2);
+			row[0] = it->t;
+			row[1] = (QuantLib::Real)it->mesher->layout()->size();
+			res.push_back(row);
+		}
+		return res;
 	}
 
 	MultiAssetBSModel::MultiAssetBSModel(
@@ -366,6 +876,66 @@ namespace QuantLibAddin {
 		: RealStochasticProcess(properties, permanent) {
 	}
 
+	std::vector< std::vector<QuantLib::Real> > correlationDecomposition(
+		const QuantLib::RealStochasticProcess::MatA&                        correlations,
+		const QuantLib::Real                                                quantum,
+		const bool                                                          returnFactor) {
+		QL_REQUIRE(quantum >= 0.0, "Non-negative quantum required.");
+		QuantLib::Size n = correlations.size();
+		QuantLib::Matrix C(n, n);
+		std::vector<QuantLib::Real> values;
+		for (QuantLib::Size i = 0; i < n; ++i) {
+			QL_REQUIRE(correlations[i].size() == n, "Square correlation matrix required.");
+			for (QuantLib::Size j = 0; j < n; ++j) {
+				C[i][j] = 0.5 * (correlations[i][j] + correlations[j][i]);
+				if (quantum > 0.0) {
+					values.push_back(std::floor(C[i][j] / quantum + 0.5));
+					C[i][j] = values.back() * quantum;
+				} else {
+					values.push_back(C[i][j]);
+				}
+			}
+		}
+		CorrelationDecompositionCache& cache = correlationDecompositionCache();
+		CorrelationDecompositionKey key(quantum, values);
+		CorrelationDecompositionEntry entry;
+		if (const CorrelationDecompositionEntry* cached = cache.find(key)) {
+			entry = *cached;
+		} else {
+			// spectral repair of non-PD inputs: floor eigenvalues at a small positive value such that
+			// the diagonal stays positive, then rescale to unit diagonal
+			QuantLib::SymmetricSchurDecomposition schur(C);
+			if (n > 0 && schur.eigenvalues()[n - 1] < minCorrelationEigenvalue) {
+				++correlationRepairs();
+				QuantLib::Matrix D(n, n, 0.0);
+				for (QuantLib::Size k = 0; k < n; ++k) D[k][k] = std::max(schur.eigenvalues()[k], minCorrelationEigenvalue);
+				C = schur.eigenvectors() * D * QuantLib::transpose(schur.eigenvectors());
+				for (QuantLib::Size i = 0; i < n; ++i)
+					for (QuantLib::Size j = 0; j < n; ++j)
+						if (i != j) C[i][j] /= std::sqrt(C[i][i] * C[j][j]);
+				for (QuantLib::Size i = 0; i < n; ++i) C[i][i] = 1.0;
+			}
+			entry = CorrelationDecompositionEntry(C, QuantLib::CholeskyDecomposition(C, true));
+			cache.insert(key, entry);
+		}
+		const QuantLib::Matrix& M = returnFactor ? entry.second : entry.first;
+		std::vector< std::vector<QuantLib::Real> > res(n, std::vector<QuantLib::Real>(n));
+		for (QuantLib::Size i = 0; i < n; ++i)
+			for (QuantLib::Size j = 0; j < n; ++j) res[i][j] = M[i][j];
+		return res;
+	}
+
+	std::vector<QuantLib::Real> correlationDecompositionCacheInfo() {
+		std::vector<QuantLib::Real> res = correlationDecompositionCache().info();
+		res.push_back((QuantLib::Real)correlationRepairs());
+		return res;
+	}
+
+	QuantLib::Size correlationDecompositionClearCache() {
+		correlationRepairs() = 0;
+		return correlationDecompositionCache().clear();
+	}
+
 	MultiAssetSLVModel::MultiAssetSLVModel(
 		const boost::shared_ptr<ObjectHandler::ValueObject>&                            properties,
 		const QuantLib::Handle<QuantLib::YieldTermStructure>&                           termStructure,
@@ -393,11 +963,12 @@ namespace QuantLibAddin {
 		QuantLib::Size														nBins,
 		QuantLib::Size														calibrationPaths,
 		const std::vector<QuantLib::Date>&									mandatoryDates,
+		QuantLib::BigNatural												seed,
 		bool                                                                permanent)
 		 : ObjectHandler::LibraryObject<QuantLib::HestonSLVMCModel>(properties, permanent) {
 		libraryObject_ = boost::shared_ptr<QuantLib::HestonSLVMCModel>(
 			new QuantLib::HestonSLVMCModel(localVol, hestonModel, boost::shared_ptr<QuantLib::BrownianGeneratorFactory>(
-				new QuantLib::MTBrownianGeneratorFactory()), endDate, timeStepsPerYear, nBins, calibrationPaths, mandatoryDates));
+				new QuantLib::MTBrownianGeneratorFactory(seed)), endDate, timeStepsPerYear, nBins, calibrationPaths, mandatoryDates));
 		
 	}
 }
@@ -76,17 +76,40 @@ namespace QuantLibAddin {
 			const std::vector<QuantLib::Real>&                                  weights,
 			const std::vector<bool>&                                            fixParameters,
 			const QuantLib::Real                                                hestonRelTolerance,
-			const QuantLib::Size                                                hestonMaxEvaluations );
+			const QuantLib::Size                                                hestonMaxEvaluations,
+			const QuantLib::Size                                                integrationOrder );
     };
 
+	// undiscounted vanilla prices (rows per term, columns per strike); the characteristic
+	// function is evaluated once per term on a Gauss-Laguerre node set shared by all strikes
+	std::vector< std::vector<QuantLib::Real> > hestonStripPrices(
+		const boost::shared_ptr<QuantLib::HestonModel>&                     model,
+		const std::vector<QuantLib::Real>&                                  forwardPrices,
+		const std::vector<QuantLib::Time>&                                  terms,
+		const std::vector<QuantLib::Real>&                                  strikePrices,
+		const long                                                          callOrPut,
+		const QuantLib::Size                                                integrationOrder);
+
 	class HestonSLVProcess : public StochasticProcess {
 	public:
 		HestonSLVProcess(const boost::shared_ptr<ObjectHandler::ValueObject>& properties, 
 			const boost::shared_ptr<QuantLib::HestonProcess>& hestonProcess,
 			const boost::shared_ptr<QuantLib::LocalVolTermStructure>& leverageFct,
+			// with positive steps the leverage function is pre-sampled on a uniform (t, log S)
+			// grid; processes on the same leverage function and grid share one table
+			const QuantLib::Size tableTimeSteps,
+			const QuantLib::Size tableLogStrikeSteps,
+			const QuantLib::Real tableMinStrike,
+			const QuantLib::Real tableMaxStrike,
 			bool permanent);
 	};
 
+	// shared leverage tables; returns number of entries, hits and misses
+	std::vector<QuantLib::Real> hestonSLVLeverageTableCacheInfo();
+
+	// returns number of removed entries; tables in use by processes are not affected
+	QuantLib::Size hestonSLVLeverageTableClearCache();
+
     class AnalyticHestonEngine : public PricingEngine {
     public:
         AnalyticHestonEngine(
@@ -118,6 +141,16 @@ namespace QuantLibAddin {
 			const boost::shared_ptr<ObjectHandler::ValueObject>&    properties,
 			const QuantLib::Handle<QuantLib::HestonModel>&          model,
 			bool                                                    permanent);
+		// implied volatilities materialised on a (time, strike) grid from strip prices and
+		// interpolated in variance; the grid is rebuilt when the model is recalibrated or the
+		// reference date of the model's risk-free curve moves
+		HestonBlackVolSurface(
+			const boost::shared_ptr<ObjectHandler::ValueObject>&    properties,
+			const QuantLib::Handle<QuantLib::HestonModel>&          model,
+			const std::vector<QuantLib::Time>&                      times,
+			const std::vector<QuantLib::Real>&                      strikes,
+			const QuantLib::Size                                    integrationOrder,
+			bool                                                    permanent);
 	};
 
 	class RealHestonModel : public ObjectHandler::LibraryObject<QuantLib::RealHestonModel> {
@@ -177,6 +210,23 @@ namespace QuantLibAddin {
   				bool                                                 permanent);			   
 	};
 
+	// vanilla prices for a vector of strikes from the time-homogeneous model with parameters
+	// averaged up to term; averaged models are memoized per model object and term
+	std::vector<QuantLib::Real> realTDStochVolModelVanillaOptions(
+		const boost::shared_ptr<QuantLib::RealTDStochVolModel>&             model,
+		const QuantLib::Real                                                forwardPrice,
+		const std::vector<QuantLib::Real>&                                  strikePrices,
+		const QuantLib::Time                                                term,
+		const long                                                          callOrPut,
+		const QuantLib::Real                                                accuracy,
+		const long                                                          maxEvaluations);
+
+	// averaged models; returns number of entries, hits and misses
+	std::vector<QuantLib::Real> realTDStochVolModelAveragedCacheInfo();
+
+	// returns number of removed entries
+	QuantLib::Size realTDStochVolModelAveragedClearCache();
+
 	class RealShiftedSABRModel : public RealStochasticProcess {
 	public:
 		RealShiftedSABRModel(
@@ -236,6 +286,19 @@ namespace QuantLibAddin {
   				bool                                                 permanent);
 	};
 
+	// calibrates independent smiles (rows of strikes and vols per exercise time); returns per
+	// expiry the parameters (lambda, b, L, theta, m, eta, z0, rho), the RMSE of normal vols and
+	// the calibration time in seconds; with warm start each expiry starts from its predecessor
+	std::vector< std::vector<QuantLib::Real> > stochVolModelCalibrateSmiles(
+		        const std::vector<QuantLib::Real>&                   initialParams,  // { lambda, b, L, theta, m, eta, z0, rho }
+		        const std::vector<bool>&                             isFixed,
+		        const std::vector<QuantLib::Real>&                   exercTimes,
+		        const std::vector<QuantLib::Real>&                   forwards,
+		        const std::vector< std::vector<QuantLib::Real> >&    strikes,
+		        const std::vector< std::vector<QuantLib::Real> >&    vols,
+				const std::vector<QuantLib::Real>&                   optimizationParams,
+				const bool                                           warmStart);
+
 	// Heston Local-Stochastic Volatility Model
 
 	// this class captures deep-in-the-model parameters
@@ -285,6 +348,11 @@ namespace QuantLibAddin {
 			const bool                                                          logging,
 			const std::vector<QuantLib::Date>&                                  mandatoryDates,
 		    bool                                                                permanent);
+		// duration of the most recent (lazy) leverage function calibration, zero if it has
+		// not run yet; log rows are (time, mesh size) per logged slice, the log table
+		// triggers the calibration if required
+		QuantLib::Real calibrationTime() const;
+		std::vector< std::vector<QuantLib::Real> > logTable() const;
 	};
 
 	class MultiAssetBSModel : public RealStochasticProcess {
@@ -308,6 +376,21 @@ namespace QuantLibAddin {
 			bool                                                                            permanent);
 	};
 
+	// positive definite correlation matrix C (as accepted by multi-asset models), or its lower
+	// triangular factor L with L L^T = C; results are memoized per exact input matrix, or with
+	// positive quantum per matrix quantised to multiples of quantum; non-PD inputs are repaired
+	// by flooring eigenvalues
+	std::vector< std::vector<QuantLib::Real> > correlationDecomposition(
+		const QuantLib::RealStochasticProcess::MatA&                        correlations,
+		const QuantLib::Real                                                quantum,
+		const bool                                                          returnFactor);
+
+	// returns number of entries, hits, misses and repairs
+	std::vector<QuantLib::Real> correlationDecompositionCacheInfo();
+
+	// returns number of removed entries and resets counters
+	QuantLib::Size correlationDecompositionClearCache();
+
 	class MultiAssetSLVModel : public RealStochasticProcess {
 	public:
 		MultiAssetSLVModel(
@@ -333,6 +416,7 @@ namespace QuantLibAddin {
 				QuantLib::Size														nBins,
 				QuantLib::Size														calibrationPaths,
 				const std::vector<QuantLib::Date>&									mandatoryDates,
+				QuantLib::BigNatural												seed,           // fixes the calibration random stream
 				bool                                                                permanent);
 			
 	};
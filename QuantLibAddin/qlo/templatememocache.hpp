@@ -0,0 +1,92 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+#ifndef qla_templatememocache_hpp
+#define qla_templatememocache_hpp
+
+#include <ql/types.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace QuantLibAddin {
+
+	// bounded memo for intermediate results of addin calculations with hit and miss counters;
+	// the least recently used entry is evicted once maxEntries is reached. Keys holding a raw
+	// object address pass that object as guard; the guard does not keep the object alive, and
+	// the entry is dropped once the object is destroyed so that a reused address never hits
+	template <class Key, class Value>
+	class MemoCache {
+	public:
+		MemoCache(const QuantLib::Size maxEntries = 100) : maxEntries_(maxEntries), hits_(0), misses_(0) {}
+		// cached value or null pointer; the pointer is valid until the next insert or clear
+		const Value* find(const Key& key) {
+			typename Entries::iterator it = entries_.find(key);
+			if (it != entries_.end() && it->second.guarded && it->second.guard.expired()) {
+				usage_.erase(it->second.usage);
+				entries_.erase(it);
+				it = entries_.end();
+			}
+			if (it == entries_.end()) {
+				++misses_;
+				return 0;
+			}
+			++hits_;
+			usage_.splice(usage_.begin(), usage_, it->second.usage);
+			return &(it->second.value);
+		}
+		void insert(const Key& key, const Value& value, const boost::weak_ptr<void>& guard = boost::weak_ptr<void>()) {
+			typename Entries::iterator it = entries_.find(key);
+			if (it != entries_.end()) {
+				usage_.erase(it->second.usage);
+				entries_.erase(it);
+			}
+			if (maxEntries_ == 0) return;
+			while (entries_.size() >= maxEntries_) {
+				entries_.erase(usage_.back());
+				usage_.pop_back();
+			}
+			usage_.push_front(key);
+			Entry entry;
+			entry.value   = value;
+			entry.guard   = guard;
+			entry.guarded = !guard.expired();
+			entry.usage   = usage_.begin();
+			entries_.insert(std::make_pair(key, entry));
+		}
+		// number of entries, hits and misses
+		std::vector<QuantLib::Real> info() const {
+			std::vector<QuantLib::Real> res(3);
+			res[0] = (QuantLib::Real)entries_.size();
+			res[1] = (QuantLib::Real)hits_;
+			res[2] = (QuantLib::Real)misses_;
+			return res;
+		}
+		// removes all entries, resets counters and returns the number of removed entries
+		QuantLib::Size clear() {
+			QuantLib::Size entries = entries_.size();
+			entries_.clear();
+			usage_.clear();
+			hits_ = 0;
+			misses_ = 0;
+			return entries;
+		}
+	private:
+		struct Entry {
+			Value                                  value;
+			boost::weak_ptr<void>                  guard;
+			bool                                   guarded;
+			typename std::list<Key>::iterator      usage;
+		};
+		typedef std::map<Key, Entry> Entries;
+		Entries                entries_;
+		std::list<Key>         usage_;    // most recently used first
+		QuantLib::Size         maxEntries_;
+		QuantLib::Size         hits_, misses_;
+	};
+
+}
+
+#endif
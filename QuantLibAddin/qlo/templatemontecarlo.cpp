@@ -8,9 +8,58 @@
 
 
 #include <qlo/templatemontecarlo.hpp>
+#include <qlo/templatememocache.hpp>
+
+#include <boost/timer.hpp>
+
+#include <algorithm>
+#include <numeric>
 
 namespace QuantLibAddin {
 
+	namespace {
+		// sub-simulation seeds are drawn from the master seed such that results are reproducible;
+		// seed zero is excluded since it refers to a clock-based seed
+		std::vector<QuantLib::BigNatural> deriveSeeds(const QuantLib::BigNatural seed, const size_t n) {
+			QL_REQUIRE(seed!=0, "Non-zero master seed required for reproducible sub-simulation seeds");
+			QuantLib::MersenneTwisterUniformRng rng(seed);
+			std::vector<QuantLib::BigNatural> seeds(n);
+			for (size_t k=0; k<n; ++k) {
+				seeds[k] = rng.nextInt32();
+				if (seeds[k]==0) seeds[k] = 1;
+			}
+			return seeds;
+		}
+
+		// sum of discounted payoffs per path
+		std::vector<QuantLib::Real> discountedPayoffSum(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >& payoffs,
+			                                            const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation) {
+			std::vector<QuantLib::Real> sum;
+			for (size_t k=0; k<payoffs.size(); ++k) {
+				std::vector<QuantLib::Real> v = QuantLib::RealMCPayoffPricer::discountedAt(payoffs[k], simulation);
+				if (sum.size()==0) sum.resize(v.size(), 0.0);
+				for (size_t p=0; p<v.size(); ++p) sum[p] += v[p];
+			}
+			return sum;
+		}
+
+		// simulates a batch of paths with its own seed and returns the path-wise sum of discounted
+		// payoffs; the simulation is released on return such that only one batch is held in memory
+		std::vector<QuantLib::Real> simulateBatch(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >& payoffs,
+			                                      const boost::shared_ptr<QuantLib::RealStochasticProcess>&       process,
+			                                      const std::vector<QuantLib::Real>&                              simTimes,
+			                                      const std::vector<QuantLib::Real>&                              obsTimes,
+			                                      const size_t                                                    nPaths,
+			                                      const QuantLib::BigNatural                                      seed,
+			                                      const bool                                                      richardsonExtrapolation,
+			                                      const bool                                                      timeInterpolation) {
+			boost::shared_ptr<QuantLib::RealMCSimulation> sim(
+				new QuantLib::RealMCSimulation( process, simTimes, obsTimes, nPaths, seed, richardsonExtrapolation, timeInterpolation, false ));
+			sim->simulate();
+			return discountedPayoffSum(payoffs, sim);
+		}
+	}
+
     // Simulation and payoff pricer
 
 	RealMCSimulation::RealMCSimulation(
@@ -41,6 +90,218 @@ namespace QuantLibAddin {
 			new QuantLib::RealMCPayoffPricer( payoffs, simulation ));
 	}
 
+	void realMCSimulationCalculateAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                    const std::vector<QuantLib::Time>&                     numeraireObservTimes,
+		                                    const std::vector<QuantLib::Time>&                     zcbObservTimes,
+		                                    const std::vector<QuantLib::Time>&                     zcbOffsetTimes,
+		                                    const std::vector<QuantLib::Time>&                     assetObservTimes,
+		                                    const std::vector<std::string>&                        aliases) {
+		if (numeraireObservTimes.size()>0) simulation->calculateNumeraireAdjuster(numeraireObservTimes);
+		if (zcbObservTimes.size()>0) {
+			QL_REQUIRE(zcbOffsetTimes.size()>0, "realMCSimulationCalculateAdjusters: zcbOffsetTimes required");
+			simulation->calculateZCBAdjuster(zcbObservTimes, zcbOffsetTimes);
+		}
+		if (assetObservTimes.size()>0) {
+			QL_REQUIRE(aliases.size()>0, "realMCSimulationCalculateAdjusters: aliases required");
+			simulation->calculateAssetAdjuster(assetObservTimes, aliases);
+		}
+	}
+
+	std::vector<QuantLib::Real> realMCSimulationNumeraireAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                           const std::vector<QuantLib::Time>&                     obsTimes) {
+		std::vector<QuantLib::Real> res(obsTimes.size());
+		for (QuantLib::Size k = 0; k < obsTimes.size(); ++k) res[k] = simulation->numeraireAdjuster(obsTimes[k]);
+		return res;
+	}
+
+	std::vector<QuantLib::Real> realMCSimulationZCBAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                     const std::vector<QuantLib::Time>&                     obsTimes,
+		                                                     const std::vector<QuantLib::Time>&                     payTimes) {
+		QL_REQUIRE(obsTimes.size()>0 && payTimes.size()>0, "realMCSimulationZCBAdjusters: obsTimes and payTimes required");
+		QL_REQUIRE(obsTimes.size()==payTimes.size() || obsTimes.size()==1 || payTimes.size()==1,
+			"realMCSimulationZCBAdjusters: obsTimes and payTimes size mismatch");
+		QuantLib::Size n = std::max(obsTimes.size(), payTimes.size());
+		std::vector<QuantLib::Real> res(n);
+		for (QuantLib::Size k = 0; k < n; ++k)
+			res[k] = simulation->zcbAdjuster(obsTimes[obsTimes.size()==1 ? 0 : k], payTimes[payTimes.size()==1 ? 0 : k]);
+		return res;
+	}
+
+	std::vector<QuantLib::Real> realMCSimulationAssetAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                       const std::vector<QuantLib::Time>&                     obsTimes,
+		                                                       const std::string&                                     alias) {
+		std::vector<QuantLib::Real> res(obsTimes.size());
+		for (QuantLib::Size k = 0; k < obsTimes.size(); ++k) res[k] = simulation->assetAdjuster(obsTimes[k], alias);
+		return res;
+	}
+
+	std::vector<QuantLib::Real> realMCPayoffsStatistics(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+		                                                const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+		                                                const QuantLib::Real                                             confidenceLevel) {
+		QL_REQUIRE(confidenceLevel>0.0 && confidenceLevel<1.0, "realMCPayoffsStatistics: confidenceLevel in (0,1) required");
+		std::vector<QuantLib::Real> values = discountedPayoffSum(payoffs, simulation);
+		QuantLib::IncrementalStatistics stats;
+		stats.addSequence(values.begin(), values.end());
+		QuantLib::Real quantile = QuantLib::InverseCumulativeNormal()(0.5 + 0.5*confidenceLevel);
+		std::vector<QuantLib::Real> res(5);
+		res[0] = stats.mean();
+		res[1] = stats.errorEstimate();
+		res[2] = res[0] - quantile*res[1];
+		res[3] = res[0] + quantile*res[1];
+		res[4] = (QuantLib::Real)stats.samples();
+		return res;
+	}
+
+	std::vector< std::vector<QuantLib::Real> > realMCPayoffsConvergence(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+		                                                                const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+		                                                                const QuantLib::Size                                             nPoints) {
+		QL_REQUIRE(nPoints>0, "realMCPayoffsConvergence: nPoints > 0 required");
+		std::vector<QuantLib::Real> values = discountedPayoffSum(payoffs, simulation);
+		QL_REQUIRE(values.size()>=nPoints, "realMCPayoffsConvergence: nPoints exceeds number of paths");
+		std::vector< std::vector<QuantLib::Real> > res;
+		QuantLib::IncrementalStatistics stats;
+		for (QuantLib::Size i = 1; i <= nPoints; ++i) {
+			// checkpoints at equidistant path numbers
+			QuantLib::Size last = (i * values.size()) / nPoints;
+			stats.addSequence(values.begin() + stats.samples(), values.begin() + last);
+			std::vector<QuantLib::Real> row(3);
+			row[0] = (QuantLib::Real)stats.samples();
+			row[1] = stats.mean();
+			row[2] = (stats.samples()>1) ? stats.errorEstimate() : 0.0;
+			res.push_back(row);
+		}
+		return res;
+	}
+
+	RealMCAdaptivePricer::RealMCAdaptivePricer(
+		                      const boost::shared_ptr<ObjectHandler::ValueObject>&              properties,
+			                  const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&   payoffs,
+			                  const boost::shared_ptr<QuantLib::RealStochasticProcess>          process,
+			                  const std::vector<QuantLib::Real>&                                simTimes,
+			                  const std::vector<QuantLib::Real>&                                obsTimes,
+			                  size_t                                                            batchPaths,
+			                  size_t                                                            maxPaths,
+			                  QuantLib::Real                                                    targetError,
+			                  QuantLib::BigNatural                                              seed,
+			                  bool                                                              richardsonExtrapolation,
+			                  bool                                                              timeInterpolation,
+			                  bool                                                              permanent)
+		: ObjectHandler::Object(properties, permanent), payoffs_(payoffs), process_(process), simTimes_(simTimes), obsTimes_(obsTimes),
+		  batchPaths_(batchPaths), maxPaths_(maxPaths), targetError_(targetError), seed_(seed),
+		  richardsonExtrapolation_(richardsonExtrapolation), timeInterpolation_(timeInterpolation), calculated_(false) {
+		QL_REQUIRE(payoffs_.size()>0, "RealMCAdaptivePricer: payoffs required");
+		QL_REQUIRE(batchPaths_>1, "RealMCAdaptivePricer: batchPaths > 1 required");
+		QL_REQUIRE(maxPaths_>=batchPaths_, "RealMCAdaptivePricer: maxPaths >= batchPaths required");
+		QL_REQUIRE(targetError_>0.0, "RealMCAdaptivePricer: targetError > 0 required");
+	}
+
+	void RealMCAdaptivePricer::calculate() {
+		stats_.reset();
+		trace_.clear();
+		// seeds are derived reproducibly; the number of batches is bounded by maxPaths
+		std::vector<QuantLib::BigNatural> seeds = deriveSeeds(seed_, (maxPaths_ + batchPaths_ - 1) / batchPaths_);
+		for (size_t k = 0; k < seeds.size(); ++k) {
+			size_t paths = std::min(batchPaths_, maxPaths_ - stats_.samples());
+			std::vector<QuantLib::Real> values = simulateBatch(payoffs_, process_, simTimes_, obsTimes_, paths, seeds[k], richardsonExtrapolation_, timeInterpolation_);
+			stats_.addSequence(values.begin(), values.end());
+			std::vector<QuantLib::Real> row(3);
+			row[0] = (QuantLib::Real)stats_.samples();
+			row[1] = stats_.mean();
+			row[2] = stats_.errorEstimate();
+			trace_.push_back(row);
+			if (row[2] <= targetError_) break;
+		}
+		calculated_ = true;
+	}
+
+	QuantLib::Real RealMCAdaptivePricer::NPV() {
+		if (!calculated_) calculate();
+		return stats_.mean();
+	}
+
+	QuantLib::Real RealMCAdaptivePricer::standardError() {
+		if (!calculated_) calculate();
+		return stats_.errorEstimate();
+	}
+
+	QuantLib::Size RealMCAdaptivePricer::paths() {
+		if (!calculated_) calculate();
+		return stats_.samples();
+	}
+
+	bool RealMCAdaptivePricer::converged() {
+		if (!calculated_) calculate();
+		return stats_.errorEstimate() <= targetError_;
+	}
+
+	std::vector< std::vector<QuantLib::Real> > RealMCAdaptivePricer::trace() {
+		if (!calculated_) calculate();
+		return trace_;
+	}
+
+	RealMCStreamingPricer::RealMCStreamingPricer(
+		                      const boost::shared_ptr<ObjectHandler::ValueObject>&              properties,
+			                  const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&   payoffs,
+			                  const boost::shared_ptr<QuantLib::RealStochasticProcess>          process,
+			                  const std::vector<QuantLib::Real>&                                simTimes,
+			                  const std::vector<QuantLib::Real>&                                obsTimes,
+			                  size_t                                                            nPaths,
+			                  QuantLib::BigNatural                                              seed,
+			                  QuantLib::Real                                                    memoryBudget,
+			                  bool                                                              richardsonExtrapolation,
+			                  bool                                                              timeInterpolation,
+			                  bool                                                              permanent)
+		: ObjectHandler::Object(properties, permanent), payoffs_(payoffs), process_(process), simTimes_(simTimes), obsTimes_(obsTimes),
+		  nPaths_(nPaths), richardsonExtrapolation_(richardsonExtrapolation), timeInterpolation_(timeInterpolation),
+		  calculated_(false), npv_(0.0), standardError_(0.0) {
+		QL_REQUIRE(payoffs_.size()>0, "RealMCStreamingPricer: payoffs required");
+		QL_REQUIRE(nPaths_>0, "RealMCStreamingPricer: nPaths > 0 required");
+		QL_REQUIRE(memoryBudget>0.0, "RealMCStreamingPricer: memoryBudget > 0 required");
+		// a path holds one state vector per simulation and observation time (incl. start point),
+		// each with its vector header and allocator bookkeeping; Richardson extrapolation requires
+		// an additional path on the coarse grid; payoff evaluation keeps a path-wise sum and value
+		size_t bytesPerState = process_->size() * sizeof(QuantLib::Real) + sizeof(std::vector<QuantLib::Real>) + 2 * sizeof(void*);
+		bytesPerPath_ = (simTimes_.size() + obsTimes_.size() + 1) * bytesPerState;
+		if (richardsonExtrapolation_) bytesPerPath_ += bytesPerPath_ / 2;
+		bytesPerPath_ += 2 * sizeof(QuantLib::Real);
+		QuantLib::Real budgetBytes = memoryBudget * 1024.0 * 1024.0;
+		chunkSize_ = (size_t)(budgetBytes / bytesPerPath_);
+		QL_REQUIRE(chunkSize_>0, "RealMCStreamingPricer: memoryBudget too small for a single path (" << bytesPerPath_ << " bytes)");
+		if (chunkSize_>nPaths_) chunkSize_ = nPaths_;
+		seeds_ = deriveSeeds(seed, (nPaths_ + chunkSize_ - 1) / chunkSize_);
+	}
+
+	void RealMCStreamingPricer::calculate() {
+		chunkNPVs_.resize(seeds_.size());
+		// statistics are accumulated path-wise such that the error estimate does not depend on the chunk layout
+		QuantLib::IncrementalStatistics stats;
+		for (size_t k=0; k<seeds_.size(); ++k) {
+			// last chunk collects the remaining paths
+			size_t paths = std::min(chunkSize_, nPaths_ - k*chunkSize_);
+			std::vector<QuantLib::Real> values = simulateBatch(payoffs_, process_, simTimes_, obsTimes_, paths, seeds_[k], richardsonExtrapolation_, timeInterpolation_);
+			chunkNPVs_[k] = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+			stats.addSequence(values.begin(), values.end());
+		}
+		npv_ = stats.mean();
+		standardError_ = (stats.samples()>1) ? stats.errorEstimate() : 0.0;
+		calculated_ = true;
+	}
+
+	QuantLib::Real RealMCStreamingPricer::NPV() {
+		if (!calculated_) calculate();
+		return npv_;
+	}
+
+	QuantLib::Real RealMCStreamingPricer::standardError() {
+		if (!calculated_) calculate();
+		return standardError_;
+	}
+
+	std::vector<QuantLib::Real> RealMCStreamingPricer::chunkNPVs() {
+		if (!calculated_) calculate();
+		return chunkNPVs_;
+	}
+
 	RealMCClone::RealMCClone(const boost::shared_ptr<ObjectHandler::ValueObject>& properties,
 		                     const boost::shared_ptr<QuantLib::RealMCPayoff>&             x,
 		                     const QuantLib::Time                                         observationTime,
@@ -324,6 +585,164 @@ namespace QuantLibAddin {
 			new QuantLib::RealRegression( controls, observations, maxDegree ));
 	}
 
+	namespace {
+		// multi-indices of all monomials up to total degree maxDegree ordered by degree;
+		// index sets only depend on dimension and degree and are cached accordingly
+		boost::shared_ptr< std::vector< std::vector<QuantLib::Size> > > multiIndexSet(const QuantLib::Size nVars, const QuantLib::Size maxDegree) {
+			typedef std::vector< std::vector<QuantLib::Size> > IndexSet;
+			static MemoCache< std::pair<QuantLib::Size, QuantLib::Size>, boost::shared_ptr<IndexSet> > cache;
+			std::pair<QuantLib::Size, QuantLib::Size> key(nVars, maxDegree);
+			const boost::shared_ptr<IndexSet>* cached = cache.find(key);
+			if (cached) return *cached;
+			boost::shared_ptr<IndexSet> set(new IndexSet(1, std::vector<QuantLib::Size>(nVars, 0)));
+			// extend monomials of degree d-1 by one more factor with non-decreasing variable index
+			std::vector<QuantLib::Size> lastVar(1, 0);
+			QuantLib::Size first = 0;
+			for (QuantLib::Size d = 1; d <= maxDegree; ++d) {
+				QuantLib::Size last = set->size();
+				for (QuantLib::Size j = first; j < last; ++j) {
+					for (QuantLib::Size v = lastVar[j]; v < nVars; ++v) {
+						std::vector<QuantLib::Size> alpha((*set)[j]);
+						++alpha[v];
+						set->push_back(alpha);
+						lastVar.push_back(v);
+					}
+				}
+				first = last;
+			}
+			cache.insert(key, set);
+			return set;
+		}
+
+		// row of monomial values of x; powers are tabulated once per variable
+		void fillMonomials(const std::vector< std::vector<QuantLib::Size> >& multiIndex, const QuantLib::Size maxDegree,
+			               const std::vector<QuantLib::Real>& x, QuantLib::Real* row) {
+			// powers[v*(maxDegree+1)+d] = x_v^d
+			std::vector<QuantLib::Real> powers(x.size()*(maxDegree+1), 1.0);
+			for (QuantLib::Size v = 0; v < x.size(); ++v)
+				for (QuantLib::Size d = 1; d <= maxDegree; ++d)
+					powers[v*(maxDegree+1)+d] = powers[v*(maxDegree+1)+d-1] * x[v];
+			for (QuantLib::Size j = 0; j < multiIndex.size(); ++j) {
+				row[j] = 1.0;
+				for (QuantLib::Size v = 0; v < x.size(); ++v)
+					if (multiIndex[j][v] > 0) row[j] *= powers[v*(maxDegree+1)+multiIndex[j][v]];
+			}
+		}
+
+		// least-squares solution of A b = y via SVD or pivoted QR; numerically zero
+		// directions are truncated and the condition number of A is returned as well
+		QuantLib::Array solveLeastSquares(const QuantLib::Matrix& A, const QuantLib::Array& y, const bool useSVD, QuantLib::Real& conditionNumber) {
+			QuantLib::Size nRows = A.rows(), nCols = A.columns();
+			QL_REQUIRE(nRows>=nCols, "solveLeastSquares: at least as many rows (" << nRows << ") as columns (" << nCols << ") required");
+			QuantLib::Array b(nCols, 0.0);
+			if (useSVD) {
+				QuantLib::SVD svd(A);
+				const QuantLib::Array& s = svd.singularValues();
+				const QuantLib::Matrix& U = svd.U();
+				const QuantLib::Matrix& V = svd.V();
+				// singular values are sorted descending
+				QuantLib::Real tol = s[0] * nRows * QL_EPSILON;
+				for (QuantLib::Size k = 0; k < nCols; ++k) {
+					if (s[k] <= tol) continue;
+					QuantLib::Real uy = std::inner_product(U.column_begin(k), U.column_end(k), y.begin(), 0.0) / s[k];
+					for (QuantLib::Size j = 0; j < nCols; ++j) b[j] += uy * V[j][k];
+				}
+				conditionNumber = (s[nCols-1] > 0.0) ? s[0] / s[nCols-1] : QL_MAX_REAL;
+			} else {
+				// A P = Q R with column pivoting, solve R z = Q^T y by back substitution
+				QuantLib::Matrix Q, R;
+				std::vector<QuantLib::Size> ipvt = QuantLib::qrDecomposition(A, Q, R, true);
+				QuantLib::Real rMax = 0.0, rMin = QL_MAX_REAL;
+				for (QuantLib::Size k = 0; k < nCols; ++k) {
+					rMax = std::max(rMax, std::fabs(R[k][k]));
+					rMin = std::min(rMin, std::fabs(R[k][k]));
+				}
+				QuantLib::Real tol = rMax * nRows * QL_EPSILON;
+				QuantLib::Array z(nCols, 0.0);
+				for (QuantLib::Size k = nCols; k > 0; --k) {
+					QuantLib::Size i = k - 1;
+					if (std::fabs(R[i][i]) <= tol) continue;
+					QuantLib::Real sum = std::inner_product(Q.column_begin(i), Q.column_end(i), y.begin(), 0.0);
+					for (QuantLib::Size j = i + 1; j < nCols; ++j) sum -= R[i][j] * z[j];
+					z[i] = sum / R[i][i];
+				}
+				for (QuantLib::Size k = 0; k < nCols; ++k) b[ipvt[k]] = z[k];
+				conditionNumber = (rMin > 0.0) ? rMax / rMin : QL_MAX_REAL;
+			}
+			return b;
+		}
+
+		// folds one row (row, y) of a least-squares system into the triangular factor R and
+		// z = Q^T y via Givens rotations; R (n x n) and z start at zero and row is overwritten
+		void givensUpdate(QuantLib::Matrix& R, QuantLib::Array& z, std::vector<QuantLib::Real>& row, QuantLib::Real y) {
+			for (QuantLib::Size j = 0; j < R.columns(); ++j) {
+				if (row[j] == 0.0) continue;
+				QuantLib::Real rho = std::sqrt(R[j][j]*R[j][j] + row[j]*row[j]);
+				QuantLib::Real c = R[j][j] / rho, s = row[j] / rho;
+				R[j][j] = rho;
+				for (QuantLib::Size l = j + 1; l < R.columns(); ++l) {
+					QuantLib::Real r = R[j][l];
+					R[j][l] = c * r + s * row[l];
+					row[l]  = c * row[l] - s * r;
+				}
+				QuantLib::Real zj = z[j];
+				z[j] = c * zj + s * y;
+				y    = c * y - s * zj;
+			}
+		}
+	}
+
+	RealLeastSquaresRegression::RealLeastSquaresRegression (
+		                          const boost::shared_ptr<ObjectHandler::ValueObject>&            properties,
+			                      const std::vector< std::vector<QuantLib::Real> >&               controls,
+			                      const std::vector<QuantLib::Real>&                              observations,
+			                      const QuantLib::Size                                            maxDegree,
+			                      const std::string&                                              method,
+			                      bool                                                            permanent)
+		: ObjectHandler::Object(properties, permanent), maxDegree_(maxDegree), conditionNumber_(0.0), residualStdDev_(0.0) {
+		QL_REQUIRE(controls.size()>0, "RealLeastSquaresRegression: controls required");
+		QL_REQUIRE(controls.size()==observations.size(), "RealLeastSquaresRegression: controls and observations size mismatch");
+		QL_REQUIRE(method=="QR" || method=="SVD", "RealLeastSquaresRegression: method 'QR' or 'SVD' required");
+		QuantLib::Size nVars = controls[0].size();
+		boost::timer t;
+		multiIndex_ = multiIndexSet(nVars, maxDegree_);
+		QuantLib::Size nRows = controls.size(), nCols = multiIndex_->size();
+		QL_REQUIRE(nRows>=nCols, "RealLeastSquaresRegression: at least " << nCols << " observations required");
+		// design matrix is filled row by row from a table of powers per observation
+		QuantLib::Matrix A(nRows, nCols);
+		for (QuantLib::Size i = 0; i < nRows; ++i) {
+			QL_REQUIRE(controls[i].size()==nVars, "RealLeastSquaresRegression: controls dimension mismatch in row " << i);
+			fillMonomials(*multiIndex_, maxDegree_, controls[i], A.row_begin(i));
+		}
+		basisTime_ = t.elapsed();
+		t.restart();
+		QuantLib::Array y(observations.begin(), observations.end());
+		QuantLib::Array b = solveLeastSquares(A, y, method=="SVD", conditionNumber_);
+		beta_ = std::vector<QuantLib::Real>(b.begin(), b.end());
+		QuantLib::Array res = A * b - y;
+		residualStdDev_ = std::sqrt(QuantLib::DotProduct(res, res) / nRows);
+		solveTime_ = t.elapsed();
+	}
+
+	std::vector<QuantLib::Real> RealLeastSquaresRegression::monomials(const std::vector<QuantLib::Real>& x) const {
+		QL_REQUIRE(x.size()==(*multiIndex_)[0].size(), "RealLeastSquaresRegression: wrong dimension of x");
+		std::vector<QuantLib::Real> res(multiIndex_->size());
+		fillMonomials(*multiIndex_, maxDegree_, x, &res[0]);
+		return res;
+	}
+
+	QuantLib::Real RealLeastSquaresRegression::value(const std::vector<QuantLib::Real>& x) const {
+		std::vector<QuantLib::Real> m = monomials(x);
+		return std::inner_product(m.begin(), m.end(), beta_.begin(), 0.0);
+	}
+
+	std::vector< std::vector<QuantLib::Real> > RealLeastSquaresRegression::multiIndex() const {
+		std::vector< std::vector<QuantLib::Real> > res(multiIndex_->size());
+		for (QuantLib::Size j = 0; j < multiIndex_->size(); ++j)
+			res[j] = std::vector<QuantLib::Real>((*multiIndex_)[j].begin(), (*multiIndex_)[j].end());
+		return res;
+	}
+
 	RealAMCMax::RealAMCMax(
 		const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
 		const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  x,
@@ -353,6 +772,201 @@ namespace QuantLibAddin {
 	}
 
 
+	RealMCExposureEngine::RealMCExposureEngine (
+		                    const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
+			                const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  cashFlows,
+			                const std::vector<QuantLib::Time>&                               payTimes,
+			                const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  regressionVariables,
+			                const std::vector<QuantLib::Time>&                               exposureTimes,
+			                const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+			                const QuantLib::Size                                             maxPolynDegree,
+			                const QuantLib::Real                                             quantile,
+			                bool                                                             permanent)
+		: ObjectHandler::Object(properties, permanent), cashFlows_(cashFlows), payTimes_(payTimes), regressionVariables_(regressionVariables),
+		  exposureTimes_(exposureTimes), simulation_(simulation), maxPolynDegree_(maxPolynDegree), quantile_(quantile), calculated_(false) {
+		QL_REQUIRE(cashFlows_.size()>0, "RealMCExposureEngine: cash flows required");
+		QL_REQUIRE(cashFlows_.size()==payTimes_.size(), "RealMCExposureEngine: cash flows and pay times size mismatch");
+		QL_REQUIRE(regressionVariables_.size()>0, "RealMCExposureEngine: regression variables required");
+		QL_REQUIRE(exposureTimes_.size()>0, "RealMCExposureEngine: exposure times required");
+		for (QuantLib::Size k = 1; k < exposureTimes_.size(); ++k)
+			QL_REQUIRE(exposureTimes_[k]>exposureTimes_[k-1], "RealMCExposureEngine: ascending exposure times required");
+		QL_REQUIRE(quantile_>0.0 && quantile_<1.0, "RealMCExposureEngine: quantile in (0,1) required");
+	}
+
+	void RealMCExposureEngine::calculate() {
+		QuantLib::Size nTimes = exposureTimes_.size();
+		ee_.assign(nTimes, 0.0); ene_.assign(nTimes, 0.0); pfe_.assign(nTimes, 0.0);
+		discountedEE_.assign(nTimes, 0.0); ev_.assign(nTimes, 0.0);
+		// cash flows ordered by pay time such that future values are accumulated backwards
+		std::vector< std::pair<QuantLib::Time, QuantLib::Size> > order(payTimes_.size());
+		for (QuantLib::Size k = 0; k < payTimes_.size(); ++k) order[k] = std::make_pair(payTimes_[k], k);
+		std::sort(order.begin(), order.end());
+		std::vector<QuantLib::Real> future;  // sum of discounted cash flows paid after current exposure time
+		boost::shared_ptr< std::vector< std::vector<QuantLib::Size> > > multiIndex = multiIndexSet(regressionVariables_.size(), maxPolynDegree_);
+		boost::shared_ptr<QuantLib::RealMCPayoff> one(new QuantLib::RealMCBase::FixedAmount(1.0));
+		QuantLib::Size next = order.size();
+		for (QuantLib::Size i = nTimes; i > 0; --i) {
+			QuantLib::Time t = exposureTimes_[i-1];
+			while (next > 0 && order[next-1].first > t) {
+				--next;
+				std::vector<QuantLib::Real> cf = QuantLib::RealMCPayoffPricer::discountedAt(cashFlows_[order[next].second], simulation_);
+				if (future.size()==0) future.resize(cf.size(), 0.0);
+				for (QuantLib::Size p = 0; p < cf.size(); ++p) future[p] += cf[p];
+			}
+			if (future.size()==0) continue;  // no cash flows left, zero exposure
+			QuantLib::Size nPaths = future.size();
+			// regression variables observed at exposure time; they are centred and scaled such that
+			// the monomial columns stay of comparable size
+			std::vector< std::vector<QuantLib::Real> > z(regressionVariables_.size());
+			for (QuantLib::Size k = 0; k < regressionVariables_.size(); ++k) {
+				boost::shared_ptr<QuantLib::RealMCPayoff> zt(new QuantLib::RealMCBase::Clone(regressionVariables_[k], t));
+				z[k] = QuantLib::RealMCPayoffPricer::at(zt, simulation_);
+				QuantLib::Real mean = std::accumulate(z[k].begin(), z[k].end(), 0.0) / nPaths;
+				QuantLib::Real var = 0.0;
+				for (QuantLib::Size p = 0; p < nPaths; ++p) var += (z[k][p] - mean) * (z[k][p] - mean);
+				QuantLib::Real scale = std::sqrt(var / nPaths);
+				if (scale <= QL_EPSILON * std::max(std::fabs(mean), 1.0)) scale = 1.0;
+				for (QuantLib::Size p = 0; p < nPaths; ++p) z[k][p] = (z[k][p] - mean) / scale;
+			}
+			// the design matrix is reduced path by path to its triangular factor via Givens rotations
+			// such that neither a per-path design matrix is held nor the normal equations are formed;
+			// the small triangular system is solved via truncated SVD
+			QuantLib::Size nCols = multiIndex->size();
+			QL_REQUIRE(nPaths>=nCols, "RealMCExposureEngine: at least " << nCols << " paths required");
+			QuantLib::Matrix R(nCols, nCols, 0.0);
+			QuantLib::Array Qty(nCols, 0.0);
+			std::vector<QuantLib::Real> x(regressionVariables_.size()), row(nCols);
+			for (QuantLib::Size p = 0; p < nPaths; ++p) {
+				for (QuantLib::Size k = 0; k < x.size(); ++k) x[k] = z[k][p];
+				fillMonomials(*multiIndex, maxPolynDegree_, x, &row[0]);
+				givensUpdate(R, Qty, row, future[p]);
+			}
+			QuantLib::Real conditionNumber;
+			QuantLib::Array beta = solveLeastSquares(R, Qty, true, conditionNumber);
+			std::vector<QuantLib::Real> discounted(nPaths);
+			for (QuantLib::Size p = 0; p < nPaths; ++p) {
+				for (QuantLib::Size k = 0; k < x.size(); ++k) x[k] = z[k][p];
+				fillMonomials(*multiIndex, maxPolynDegree_, x, &row[0]);
+				discounted[p] = std::inner_product(row.begin(), row.end(), beta.begin(), 0.0);
+			}
+			// numeraire at exposure time via discounted unit payment 1/N(t)
+			boost::shared_ptr<QuantLib::RealMCPayoff> unit(new QuantLib::RealMCBase::Pay(one, t));
+			std::vector<QuantLib::Real> invN = QuantLib::RealMCPayoffPricer::discountedAt(unit, simulation_);
+			std::vector<QuantLib::Real> values(nPaths);
+			for (QuantLib::Size p = 0; p < nPaths; ++p) {
+				values[p] = discounted[p] / invN[p];
+				ev_[i-1]           += values[p];
+				ee_[i-1]           += std::max(values[p], 0.0);
+				ene_[i-1]          += std::min(values[p], 0.0);
+				discountedEE_[i-1] += std::max(discounted[p], 0.0);
+			}
+			ev_[i-1] /= nPaths; ee_[i-1] /= nPaths; ene_[i-1] /= nPaths; discountedEE_[i-1] /= nPaths;
+			QuantLib::Size q = std::min((QuantLib::Size)(quantile_ * nPaths), nPaths - 1);
+			std::nth_element(values.begin(), values.begin() + q, values.end());
+			pfe_[i-1] = std::max(values[q], 0.0);
+		}
+		calculated_ = true;
+	}
+
+	std::vector<QuantLib::Real> RealMCExposureEngine::expectedExposure() {
+		if (!calculated_) calculate();
+		return ee_;
+	}
+
+	std::vector<QuantLib::Real> RealMCExposureEngine::expectedNegativeExposure() {
+		if (!calculated_) calculate();
+		return ene_;
+	}
+
+	std::vector<QuantLib::Real> RealMCExposureEngine::potentialFutureExposure() {
+		if (!calculated_) calculate();
+		return pfe_;
+	}
+
+	std::vector<QuantLib::Real> RealMCExposureEngine::discountedExpectedExposure() {
+		if (!calculated_) calculate();
+		return discountedEE_;
+	}
+
+	std::vector<QuantLib::Real> RealMCExposureEngine::expectedValue() {
+		if (!calculated_) calculate();
+		return ev_;
+	}
+
+	RealMCControlVariatePricer::RealMCControlVariatePricer (
+		                          const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
+			                      const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+			                      const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  controls,
+			                      const std::vector<QuantLib::Real>&                               controlPrices,
+			                      const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+			                      bool                                                             permanent)
+		: ObjectHandler::Object(properties, permanent), payoffs_(payoffs), controls_(controls), controlPrices_(controlPrices),
+		  simulation_(simulation), calculated_(false), npv_(0.0), stdErr_(0.0), cvNpv_(0.0), cvStdErr_(0.0) {
+		QL_REQUIRE(payoffs_.size()>0, "RealMCControlVariatePricer: payoffs required");
+		QL_REQUIRE(controls_.size()>0, "RealMCControlVariatePricer: controls required");
+		QL_REQUIRE(controls_.size()==controlPrices_.size(), "RealMCControlVariatePricer: controls and controlPrices size mismatch");
+	}
+
+	void RealMCControlVariatePricer::calculate() {
+		std::vector<QuantLib::Real> y = discountedPayoffSum(payoffs_, simulation_);
+		QuantLib::Size nPaths = y.size();
+		QL_REQUIRE(nPaths > controls_.size() + 1, "RealMCControlVariatePricer: too few paths for " << controls_.size() << " controls");
+		// regress payoff on [1, controls]; the slope coefficients are the optimal control weights
+		QuantLib::Matrix A(nPaths, controls_.size() + 1, 1.0);
+		controlNPVs_.resize(controls_.size());
+		for (QuantLib::Size k = 0; k < controls_.size(); ++k) {
+			std::vector<QuantLib::Real> x = QuantLib::RealMCPayoffPricer::discountedAt(controls_[k], simulation_);
+			QL_REQUIRE(x.size()==nPaths, "RealMCControlVariatePricer: control " << k << " path number mismatch");
+			for (QuantLib::Size p = 0; p < nPaths; ++p) A[p][k+1] = x[p];
+			controlNPVs_[k] = std::accumulate(x.begin(), x.end(), 0.0) / nPaths;
+		}
+		QuantLib::Real conditionNumber;
+		QuantLib::Array b = solveLeastSquares(A, QuantLib::Array(y.begin(), y.end()), true, conditionNumber);
+		beta_ = std::vector<QuantLib::Real>(b.begin() + 1, b.end());
+		QuantLib::IncrementalStatistics plain, adjusted;
+		for (QuantLib::Size p = 0; p < nPaths; ++p) {
+			QuantLib::Real z = y[p];
+			for (QuantLib::Size k = 0; k < controls_.size(); ++k) z -= beta_[k] * (A[p][k+1] - controlPrices_[k]);
+			plain.add(y[p]);
+			adjusted.add(z);
+		}
+		npv_      = plain.mean();
+		stdErr_   = plain.errorEstimate();
+		cvNpv_    = adjusted.mean();
+		cvStdErr_ = adjusted.errorEstimate();
+		calculated_ = true;
+	}
+
+	QuantLib::Real RealMCControlVariatePricer::NPV() {
+		if (!calculated_) calculate();
+		return npv_;
+	}
+
+	QuantLib::Real RealMCControlVariatePricer::standardError() {
+		if (!calculated_) calculate();
+		return stdErr_;
+	}
+
+	QuantLib::Real RealMCControlVariatePricer::controlVariateNPV() {
+		if (!calculated_) calculate();
+		return cvNpv_;
+	}
+
+	QuantLib::Real RealMCControlVariatePricer::controlVariateStandardError() {
+		if (!calculated_) calculate();
+		return cvStdErr_;
+	}
+
+	std::vector<QuantLib::Real> RealMCControlVariatePricer::beta() {
+		if (!calculated_) calculate();
+		return beta_;
+	}
+
+	std::vector<QuantLib::Real> RealMCControlVariatePricer::controlNPVs() {
+		if (!calculated_) calculate();
+		return controlNPVs_;
+	}
+
 	// more rates pricing and analysis objects
 
 	RealMCAnnuity::RealMCAnnuity( 
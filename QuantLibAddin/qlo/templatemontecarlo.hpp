@@ -13,6 +13,11 @@
 
 #include <ql/types.hpp>
 
+#include <ql/math/statistics/incrementalstatistics.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
+#include <ql/math/matrixutilities/qrdecomposition.hpp>
 #include <ql/experimental/templatemodels/montecarlo/montecarlomodells.hpp>
 #include <ql/experimental/basismodels/swaptioncfs.hpp>
 
@@ -58,6 +63,127 @@ namespace QuantLibAddin {
 			                  bool permanent);
 	};
 
+	// adjuster set-up in a single call and vectorised adjuster lookups; empty time grids
+	// skip the respective adjuster
+
+	void realMCSimulationCalculateAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                    const std::vector<QuantLib::Time>&                     numeraireObservTimes,
+		                                    const std::vector<QuantLib::Time>&                     zcbObservTimes,
+		                                    const std::vector<QuantLib::Time>&                     zcbOffsetTimes,
+		                                    const std::vector<QuantLib::Time>&                     assetObservTimes,
+		                                    const std::vector<std::string>&                        aliases);
+
+	std::vector<QuantLib::Real> realMCSimulationNumeraireAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                           const std::vector<QuantLib::Time>&                     obsTimes);
+
+	// obsTimes and payTimes of equal size or one of them a single time
+	std::vector<QuantLib::Real> realMCSimulationZCBAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                     const std::vector<QuantLib::Time>&                     obsTimes,
+		                                                     const std::vector<QuantLib::Time>&                     payTimes);
+
+	std::vector<QuantLib::Real> realMCSimulationAssetAdjusters(const boost::shared_ptr<QuantLib::RealMCSimulation>&  simulation,
+		                                                       const std::vector<QuantLib::Time>&                     obsTimes,
+		                                                       const std::string&                                     alias);
+
+	// path-wise statistics of discounted payoffs; returns NPV, standard error, lower and
+	// upper confidence bound and number of paths
+	std::vector<QuantLib::Real> realMCPayoffsStatistics(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+		                                                const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+		                                                const QuantLib::Real                                             confidenceLevel);
+
+	// running mean and standard error after an increasing number of paths; rows are
+	// (paths, mean, standard error)
+	std::vector< std::vector<QuantLib::Real> > realMCPayoffsConvergence(const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+		                                                                const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+		                                                                const QuantLib::Size                                             nPoints);
+
+	// simulates batches with derived seeds until the standard error of the NPV falls below
+	// a target or a maximum number of paths is reached
+
+	class RealMCAdaptivePricer : public ObjectHandler::Object {
+	public:
+		RealMCAdaptivePricer(const boost::shared_ptr<ObjectHandler::ValueObject>&              properties,
+			                 const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&   payoffs,
+			                 const boost::shared_ptr<QuantLib::RealStochasticProcess>          process,
+			                 const std::vector<QuantLib::Real>&                                simTimes,
+			                 const std::vector<QuantLib::Real>&                                obsTimes,
+			                 size_t                                                            batchPaths,
+			                 size_t                                                            maxPaths,
+			                 QuantLib::Real                                                    targetError,
+			                 QuantLib::BigNatural                                              seed,
+			                 bool                                                              richardsonExtrapolation,
+			                 bool                                                              timeInterpolation,
+			                 bool                                                              permanent);
+		// simulate batches until target error or maximum paths
+		void calculate();
+		// inspectors (trigger calculation if required)
+		QuantLib::Real NPV();
+		QuantLib::Real standardError();
+		QuantLib::Size paths();
+		bool converged();
+		// rows (paths, mean, standard error) after each batch
+		std::vector< std::vector<QuantLib::Real> > trace();
+	protected:
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  payoffs_;
+		boost::shared_ptr<QuantLib::RealStochasticProcess>        process_;
+		std::vector<QuantLib::Real>                               simTimes_;
+		std::vector<QuantLib::Real>                               obsTimes_;
+		size_t                                                    batchPaths_;
+		size_t                                                    maxPaths_;
+		QuantLib::Real                                            targetError_;
+		QuantLib::BigNatural                                      seed_;
+		bool                                                      richardsonExtrapolation_;
+		bool                                                      timeInterpolation_;
+		// results
+		bool                                                      calculated_;
+		QuantLib::IncrementalStatistics                           stats_;
+		std::vector< std::vector<QuantLib::Real> >                trace_;
+	};
+
+	// chunk-wise simulation and pricing such that peak memory is bounded by a given budget;
+	// chunks are simulated with derived seeds, priced and released before the next chunk
+
+	class RealMCStreamingPricer : public ObjectHandler::Object {
+	public:
+		RealMCStreamingPricer(const boost::shared_ptr<ObjectHandler::ValueObject>&              properties,
+			                  const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&   payoffs,
+			                  const boost::shared_ptr<QuantLib::RealStochasticProcess>          process,
+			                  const std::vector<QuantLib::Real>&                                simTimes,
+			                  const std::vector<QuantLib::Real>&                                obsTimes,
+			                  size_t                                                            nPaths,
+			                  QuantLib::BigNatural                                              seed,
+			                  QuantLib::Real                                                    memoryBudget,  // in MB
+			                  bool                                                              richardsonExtrapolation,
+			                  bool                                                              timeInterpolation,
+			                  bool                                                              permanent);
+		// simulate and price chunk by chunk
+		void calculate();
+		// inspectors (trigger calculation if required)
+		QuantLib::Real NPV();
+		QuantLib::Real standardError();
+		std::vector<QuantLib::Real> chunkNPVs();
+		// chunk layout
+		QuantLib::Size bytesPerPath() const { return bytesPerPath_; }
+		QuantLib::Size chunkSize() const { return chunkSize_; }
+		QuantLib::Size numberOfChunks() const { return seeds_.size(); }
+	protected:
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  payoffs_;
+		boost::shared_ptr<QuantLib::RealStochasticProcess>        process_;
+		std::vector<QuantLib::Real>                               simTimes_;
+		std::vector<QuantLib::Real>                               obsTimes_;
+		size_t                                                    nPaths_;
+		bool                                                      richardsonExtrapolation_;
+		bool                                                      timeInterpolation_;
+		size_t                                                    bytesPerPath_;
+		size_t                                                    chunkSize_;
+		std::vector<QuantLib::BigNatural>                         seeds_;
+		// results
+		bool                                                      calculated_;
+		QuantLib::Real                                            npv_;
+		QuantLib::Real                                            standardError_;
+		std::vector<QuantLib::Real>                               chunkNPVs_;
+	};
+
 	// basic (general) payoffs and payoff-operations
 
 	OH_LIB_CLASS(RealMCPayoff, QuantLib::RealMCPayoff);
@@ -312,6 +438,40 @@ namespace QuantLibAddin {
 			              bool                                                            permanent);
 	};
 
+	// least-squares regression on a monomial basis solved via QR or SVD instead of the
+	// normal equations; the multi-index set is cached and shared across regressions with
+	// the same number of variables and degree (e.g. along call dates)
+
+	class RealLeastSquaresRegression : public ObjectHandler::Object {
+	public:
+		RealLeastSquaresRegression (  const boost::shared_ptr<ObjectHandler::ValueObject>&            properties,
+			                          const std::vector< std::vector<QuantLib::Real> >&               controls,
+			                          const std::vector<QuantLib::Real>&                              observations,
+			                          const QuantLib::Size                                            maxDegree,
+			                          const std::string&                                              method,      // 'QR' or 'SVD'
+			                          bool                                                            permanent);
+		// basis evaluation and regression value
+		std::vector<QuantLib::Real> monomials(const std::vector<QuantLib::Real>& x) const;
+		QuantLib::Real value(const std::vector<QuantLib::Real>& x) const;
+		// inspectors
+		const std::vector<QuantLib::Real>& beta() const { return beta_; }
+		std::vector< std::vector<QuantLib::Real> > multiIndex() const;
+		QuantLib::Size maxDegree() const { return maxDegree_; }
+		QuantLib::Real conditionNumber() const { return conditionNumber_; }
+		QuantLib::Real residualStdDev() const { return residualStdDev_; }
+		// timing (in seconds)
+		QuantLib::Real basisTime() const { return basisTime_; }
+		QuantLib::Real solveTime() const { return solveTime_; }
+	protected:
+		QuantLib::Size                                       maxDegree_;
+		boost::shared_ptr< std::vector< std::vector<QuantLib::Size> > > multiIndex_;
+		std::vector<QuantLib::Real>                          beta_;
+		QuantLib::Real                                       conditionNumber_;
+		QuantLib::Real                                       residualStdDev_;
+		QuantLib::Real                                       basisTime_;
+		QuantLib::Real                                       solveTime_;
+	};
+
 	class RealAMCMax : public RealMCPayoff {
 	public:
 		RealAMCMax(const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
@@ -337,6 +497,71 @@ namespace QuantLibAddin {
 	};
 
 
+	// exposure profiles of a netting set of cash flows; future values at each exposure time
+	// are estimated by regressing discounted future cash flows on regression variables
+	// observed at that time
+
+	class RealMCExposureEngine : public ObjectHandler::Object {
+	public:
+		RealMCExposureEngine (  const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
+			                    const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  cashFlows,
+			                    const std::vector<QuantLib::Time>&                               payTimes,
+			                    const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  regressionVariables,
+			                    const std::vector<QuantLib::Time>&                               exposureTimes,
+			                    const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+			                    const QuantLib::Size                                             maxPolynDegree,
+			                    const QuantLib::Real                                             quantile,
+			                    bool                                                             permanent);
+		// estimate exposures for all exposure times
+		void calculate();
+		// profiles per exposure time (trigger calculation if required)
+		const std::vector<QuantLib::Time>& exposureTimes() const { return exposureTimes_; }
+		std::vector<QuantLib::Real> expectedExposure();
+		std::vector<QuantLib::Real> expectedNegativeExposure();
+		std::vector<QuantLib::Real> potentialFutureExposure();
+		std::vector<QuantLib::Real> discountedExpectedExposure();
+		std::vector<QuantLib::Real> expectedValue();
+	protected:
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  cashFlows_;
+		std::vector<QuantLib::Time>                               payTimes_;
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  regressionVariables_;
+		std::vector<QuantLib::Time>                               exposureTimes_;
+		boost::shared_ptr<QuantLib::RealMCSimulation>             simulation_;
+		QuantLib::Size                                            maxPolynDegree_;
+		QuantLib::Real                                            quantile_;
+		bool                                                      calculated_;
+		std::vector<QuantLib::Real>                               ee_, ene_, pfe_, discountedEE_, ev_;
+	};
+
+	// control variate pricer; controls are payoffs with known (discounted) expectations,
+	// regression coefficients are estimated from the same paths
+
+	class RealMCControlVariatePricer : public ObjectHandler::Object {
+	public:
+		RealMCControlVariatePricer (  const boost::shared_ptr<ObjectHandler::ValueObject>&             properties,
+			                          const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  payoffs,
+			                          const std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >&  controls,
+			                          const std::vector<QuantLib::Real>&                               controlPrices,
+			                          const boost::shared_ptr<QuantLib::RealMCSimulation>&             simulation,
+			                          bool                                                             permanent);
+		void calculate();
+		// plain and control variate adjusted estimates (trigger calculation if required)
+		QuantLib::Real NPV();
+		QuantLib::Real standardError();
+		QuantLib::Real controlVariateNPV();
+		QuantLib::Real controlVariateStandardError();
+		std::vector<QuantLib::Real> beta();
+		std::vector<QuantLib::Real> controlNPVs();
+	protected:
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  payoffs_;
+		std::vector< boost::shared_ptr<QuantLib::RealMCPayoff> >  controls_;
+		std::vector<QuantLib::Real>                               controlPrices_;
+		boost::shared_ptr<QuantLib::RealMCSimulation>             simulation_;
+		bool                                                      calculated_;
+		QuantLib::Real                                            npv_, stdErr_, cvNpv_, cvStdErr_;
+		std::vector<QuantLib::Real>                               beta_, controlNPVs_;
+	};
+
 	// more rates pricing and analysis objects
 
 	class RealMCAnnuity : public RealMCPayoff {
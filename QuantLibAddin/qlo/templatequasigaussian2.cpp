@@ -6,15 +6,201 @@
 */
 
 #include <boost/algorithm/string.hpp>
+#include <boost/timer.hpp>
+
+#include <sstream>
 
 #include <ql/math/rounding.hpp>
+#include <ql/pricingengines/blackformula.hpp>
 #include <ql/indexes/swapindex.hpp>
 #include <ql/experimental/basismodels/swaptioncfs.hpp>
 #include <qlo/templatequasigaussian2.hpp>
+#include <qlo/templatememocache.hpp>
 #include <ql/experimental/templatemodels/qgaussian2/qglsvmodel.hpp>
 
 namespace QuantLibAddin {
 
+	namespace {
+
+		// swap rate models are memoized by the values of the quasi-Gaussian model parameters, the
+		// schedule and the model's discount factors on schedule and model times instead of by model
+		// object; calibrations and bumped models create new model objects with recurring parameters,
+		// and curve relinks or quote changes alter the discount factors. The yield curve object is
+		// part of the key and guards the entry such that a reused curve address never hits
+		typedef std::pair<const QuantLib::YieldTermStructure*, std::vector<QuantLib::Real> > SwaprateModelKey;
+		typedef MemoCache< SwaprateModelKey, boost::shared_ptr<QuantLib::QGSwaprateModel> > SwaprateModelCache;
+
+		SwaprateModelCache& swaprateModelCache() {
+			static SwaprateModelCache cache(1000);
+			return cache;
+		}
+
+		void appendValues(std::vector<QuantLib::Real>& key, const std::vector<QuantLib::Real>& values) {
+			key.push_back((QuantLib::Real)values.size());
+			key.insert(key.end(), values.begin(), values.end());
+		}
+
+		boost::shared_ptr<QuantLib::QGSwaprateModel> cachedSwaprateModel(
+			const boost::shared_ptr<QuantLib::QuasiGaussianModel>&       model,
+			const std::vector<QuantLib::Time>&                           floatTimes,
+			const std::vector<QuantLib::Real>&                           floatWeights,
+			const std::vector<QuantLib::Time>&                           fixedTimes,
+			const std::vector<QuantLib::Real>&                           fixedWeights,
+			const std::vector<QuantLib::Time>&                           modelTimes,
+			const bool                                                   useExpectedXY) {
+			// key holds sizes and values of all inputs
+			std::vector<QuantLib::Real> values;
+			values.push_back((QuantLib::Real)model->factors());
+			values.push_back(model->theta());
+			values.push_back(useExpectedXY ? 1.0 : 0.0);
+			appendValues(values, model->times());
+			for (QuantLib::Size i = 0; i < model->sigma().size(); ++i) appendValues(values, model->sigma()[i]);
+			for (QuantLib::Size i = 0; i < model->slope().size(); ++i) appendValues(values, model->slope()[i]);
+			for (QuantLib::Size i = 0; i < model->curve().size(); ++i) appendValues(values, model->curve()[i]);
+			appendValues(values, model->eta());
+			appendValues(values, model->delta());
+			appendValues(values, model->chi());
+			for (QuantLib::Size i = 0; i < model->Gamma().size(); ++i) appendValues(values, model->Gamma()[i]);
+			appendValues(values, floatTimes);
+			appendValues(values, floatWeights);
+			appendValues(values, fixedTimes);
+			appendValues(values, fixedWeights);
+			appendValues(values, modelTimes);
+			for (QuantLib::Size k = 0; k < floatTimes.size(); ++k) values.push_back(model->termStructure()->discount(floatTimes[k]));
+			for (QuantLib::Size k = 0; k < fixedTimes.size(); ++k) values.push_back(model->termStructure()->discount(fixedTimes[k]));
+			for (QuantLib::Size k = 0; k < modelTimes.size(); ++k) values.push_back(model->termStructure()->discount(modelTimes[k]));
+			boost::shared_ptr<QuantLib::YieldTermStructure> curve = model->termStructure().currentLink();
+			SwaprateModelKey key(curve.get(), values);
+			SwaprateModelCache& cache = swaprateModelCache();
+			if (const boost::shared_ptr<QuantLib::QGSwaprateModel>* cached = cache.find(key)) return *cached;
+			boost::shared_ptr<QuantLib::QGSwaprateModel> swapRateModel(
+				new QuantLib::QGSwaprateModel(model, floatTimes, floatWeights, fixedTimes, fixedWeights, modelTimes, useExpectedXY));
+			cache.insert(key, swapRateModel, curve);
+			return swapRateModel;
+		}
+
+		// regular model time grid up to fixing time for swap rate model discretisation
+		std::vector<QuantLib::Time> rollOutModelTimes(const QuantLib::Time fixingTime, const QuantLib::Size timePointsPerYear) {
+			QuantLib::Size numberOfRegularPoints = (QuantLib::Size) (fixingTime * timePointsPerYear);  // this is rounded to the lower integer
+			std::vector<QuantLib::Time> modelTimes(numberOfRegularPoints + 1);
+			modelTimes[0] = 0.0;
+			for (QuantLib::Size k = 1; k < numberOfRegularPoints + 1; ++k) modelTimes[k] = modelTimes[k - 1] + 1.0 / timePointsPerYear;
+			if (modelTimes[numberOfRegularPoints]<fixingTime - 1.0 / 365.0) modelTimes.push_back(fixingTime);  // we want to avoid too close grid points
+			else modelTimes[numberOfRegularPoints] = fixingTime;
+			return modelTimes;
+		}
+
+		// discount curve of the swap index cash flows
+		QuantLib::Handle<QuantLib::YieldTermStructure> swapIndexDiscountCurve(const boost::shared_ptr<QuantLib::SwapIndex>& swapIndex) {
+			return swapIndex->exogenousDiscount() ? swapIndex->discountingTermStructure() : swapIndex->forwardingTermStructure();
+		}
+
+		// fixing date of a swap index for a model time, assuming act/365 day counting
+		QuantLib::Date swapIndexFixingDate(const boost::shared_ptr<QuantLib::SwapIndex>& swapIndex, const QuantLib::Time fixingTime) {
+			QuantLib::Date today = swapIndexDiscountCurve(swapIndex)->referenceDate();
+			return swapIndex->fixingCalendar().adjust(today + ((QuantLib::BigInteger)QuantLib::ClosestRounding(0)(fixingTime*365.0)));
+		}
+
+		// undiscounted ATM swaption prices of the averaged swap rate model per swap index and
+		// positive model time; fixings not after minTime are skipped and reported as zero
+		std::vector<QuantLib::Real> atmModelPrices(
+			const boost::shared_ptr<QuantLib::QuasiGaussianModel>&          model,
+			const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&    swapIndices,
+			const QuantLib::Size                                            timePointsPerYear,
+			const bool                                                      useExpectedXY,
+			const QuantLib::Time                                            minTime,
+			const bool                                                      useCache) {
+			std::vector<QuantLib::Real> prices;
+			for (QuantLib::Size i = 0; i < swapIndices.size(); ++i) {
+				QuantLib::Handle<QuantLib::YieldTermStructure> discountCurve = swapIndexDiscountCurve(swapIndices[i]);
+				for (QuantLib::Size k = 0; k < model->times().size(); ++k) {
+					QuantLib::Time fixingTime = model->times()[k];
+					if (fixingTime <= 0.0) continue;
+					if (fixingTime <= minTime) {
+						prices.push_back(0.0);
+						continue;
+					}
+					QuantLib::Date fixingDate = swapIndexFixingDate(swapIndices[i], fixingTime);
+					QuantLib::SwapCashFlows scf(swapIndices[i]->underlyingSwap(fixingDate), discountCurve, true);
+					std::vector<QuantLib::Time> modelTimes = rollOutModelTimes(fixingTime, timePointsPerYear);
+					boost::shared_ptr<QuantLib::QGSwaprateModel> swapRateModel = useCache ?
+						cachedSwaprateModel(model, scf.floatTimes(), scf.floatWeights(), scf.fixedTimes(), scf.annuityWeights(), modelTimes, useExpectedXY) :
+						boost::shared_ptr<QuantLib::QGSwaprateModel>(new QuantLib::QGSwaprateModel(model,
+							scf.floatTimes(), scf.floatWeights(), scf.fixedTimes(), scf.annuityWeights(), modelTimes, useExpectedXY));
+					QuantLib::QGAverageSwaprateModel averageModel(swapRateModel);
+					QuantLib::Rate forward = swapIndices[i]->fixing(fixingDate);
+					prices.push_back(averageModel.vanillaOption(forward, 1, 1.0e-6, 1000));
+				}
+			}
+			return prices;
+		}
+
+		// root mean squared residual of the calibration objective on model times and swap indices;
+		// like the calibrator it weights ATM level, skew and smile curvature differences of the
+		// averaged swap rate model to the volatility surface and adds the multi-factor penalties.
+		// Skew and curvature are measured as first and second price differences at strikes of
+		// forward -/+ half a standard deviation such that all residuals are in price units
+		QuantLib::Real calibrationObjective(
+			const boost::shared_ptr<QuantLib::QuasiGaussianModel>&          model,
+			const QuantLib::Handle<QuantLib::SwaptionVolatilityStructure>&  volTS,
+			const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&    swapIndices,
+			const QuantLib::Real                                            modelTimesStepSize,
+			const bool                                                      useExpectedXY,
+			const QuantLib::Real                                            sigmaWeight,
+			const QuantLib::Real                                            slopeWeight,
+			const QuantLib::Real                                            etaWeight,
+			const QuantLib::Real                                            penaltySigma,
+			const QuantLib::Real                                            penaltySlope) {
+			QuantLib::Size timePointsPerYear = std::max((QuantLib::Size)1, (QuantLib::Size)(1.0 / modelTimesStepSize + 0.5));
+			QuantLib::Real sum = 0.0;
+			QuantLib::Size count = 0;
+			for (QuantLib::Size i = 0; i < swapIndices.size(); ++i) {
+				QuantLib::Handle<QuantLib::YieldTermStructure> discountCurve = swapIndexDiscountCurve(swapIndices[i]);
+				for (QuantLib::Size k = 0; k < model->times().size(); ++k) {
+					QuantLib::Time fixingTime = model->times()[k];
+					if (fixingTime <= 0.0) continue;
+					QuantLib::Date fixingDate = swapIndexFixingDate(swapIndices[i], fixingTime);
+					QuantLib::SwapCashFlows scf(swapIndices[i]->underlyingSwap(fixingDate), discountCurve, true);
+					QuantLib::QGAverageSwaprateModel averageModel(cachedSwaprateModel(model,
+						scf.floatTimes(), scf.floatWeights(), scf.fixedTimes(), scf.annuityWeights(), rollOutModelTimes(fixingTime, timePointsPerYear), useExpectedXY));
+					QuantLib::Rate forward = swapIndices[i]->fixing(fixingDate);
+					bool normal = (volTS->volatilityType() == QuantLib::Normal);
+					QuantLib::Real shift = normal ? 0.0 : volTS->shift(fixingDate, swapIndices[i]->tenor());
+					QuantLib::Real atmStdDev = std::sqrt(volTS->blackVariance(fixingDate, swapIndices[i]->tenor(), forward));
+					QuantLib::Real h = 0.5 * std::max(normal ? atmStdDev : atmStdDev * (forward + shift), 1.0e-4);
+					if (!normal) h = std::min(h, 0.5 * (forward + shift));
+					QuantLib::Real modelPrices[3], marketPrices[3];
+					for (QuantLib::Size j = 0; j < 3; ++j) {
+						QuantLib::Rate strike = forward + ((QuantLib::Real)j - 1.0) * h;
+						QuantLib::Real stdDev = std::sqrt(volTS->blackVariance(fixingDate, swapIndices[i]->tenor(), strike));
+						marketPrices[j] = normal ?
+							QuantLib::bachelierBlackFormula(QuantLib::Option::Call, strike, forward, stdDev) :
+							QuantLib::blackFormula(QuantLib::Option::Call, strike, forward, stdDev, 1.0, shift);
+						modelPrices[j] = averageModel.vanillaOption(strike, 1, 1.0e-6, 1000);
+					}
+					QuantLib::Real atm   = sigmaWeight * (modelPrices[1] - marketPrices[1]);
+					QuantLib::Real skew  = slopeWeight * 0.5 * ((modelPrices[2] - modelPrices[0]) - (marketPrices[2] - marketPrices[0]));
+					QuantLib::Real curve = etaWeight * ((modelPrices[2] - 2.0 * modelPrices[1] + modelPrices[0]) - (marketPrices[2] - 2.0 * marketPrices[1] + marketPrices[0]));
+					sum += atm * atm + skew * skew + curve * curve;
+					count += 3;
+				}
+			}
+			// multi-factor regularisation penalises differences of adjacent factor parameters
+			const std::vector< std::vector<QuantLib::Real> >& sigma = model->sigma();
+			const std::vector< std::vector<QuantLib::Real> >& slope = model->slope();
+			for (QuantLib::Size f = 1; f < sigma.size(); ++f) {
+				for (QuantLib::Size k = 0; k < model->times().size(); ++k) {
+					QuantLib::Real dSigma = penaltySigma * (sigma[f][k] - sigma[f - 1][k]);
+					QuantLib::Real dSlope = penaltySlope * (slope[f][k] - slope[f - 1][k]);
+					sum += dSigma * dSigma + dSlope * dSlope;
+					count += 2;
+				}
+			}
+			return (count > 0) ? std::sqrt(sum / count) : 0.0;
+		}
+
+	}
+
 	QuasiGaussianModel::QuasiGaussianModel(
         const boost::shared_ptr<ObjectHandler::ValueObject>& properties,
         const QuantLib::Handle<QuantLib::YieldTermStructure>& hYTS,
@@ -60,8 +246,7 @@ namespace QuantLibAddin {
 		const std::vector<QuantLib::Time>&                           modelTimes,   // time grid for numerical integration
 		const bool                                                   useExpectedXY, // evaluate E^A [ x(t) ], E^A [ y(t) ] as expansion points
 		bool permanent) : RealStochasticProcess(properties, permanent) {
-		libraryObject_ = boost::shared_ptr<QuantLib::QGSwaprateModel>(
-			new QuantLib::QGSwaprateModel(model, floatTimes, floatWeights, fixedTimes, fixedWeights, modelTimes, useExpectedXY));
+		libraryObject_ = cachedSwaprateModel(model, floatTimes, floatWeights, fixedTimes, fixedWeights, modelTimes, useExpectedXY);
 	}
 
 	QGSwaprateModel::QGSwaprateModel(
@@ -75,15 +260,9 @@ namespace QuantLibAddin {
 		// use swaption cash flow model
 		QuantLib::SwaptionCashFlows cf(swaption, discountCurve);
 		// we need to roll out the model time grid for discretisation
-		QuantLib::Size numberOfRegularPoints = (QuantLib::Size) (cf.exerciseTimes()[0] * timePointsPerYear);  // this is rounded to the lower integer
-		std::vector<QuantLib::Time> modelTimes(numberOfRegularPoints+1);
-		modelTimes[0] = 0.0;
-		for (QuantLib::Size k = 1; k < numberOfRegularPoints + 1; ++k) modelTimes[k] = modelTimes[k - 1] + 1.0 / timePointsPerYear;
-		if (modelTimes[numberOfRegularPoints]<cf.exerciseTimes()[0]-1.0/365.0) modelTimes.push_back(cf.exerciseTimes()[0]);  // we want to avoid too close grid points
-		else modelTimes[numberOfRegularPoints] = cf.exerciseTimes()[0];
+		std::vector<QuantLib::Time> modelTimes = rollOutModelTimes(cf.exerciseTimes()[0], timePointsPerYear);
 		// finally, we may set up the model
-		libraryObject_ = boost::shared_ptr<QuantLib::QGSwaprateModel>(
-			new QuantLib::QGSwaprateModel(model, cf.floatTimes(), cf.floatWeights(), cf.fixedTimes(), cf.annuityWeights(), modelTimes, useExpectedXY));
+		libraryObject_ = cachedSwaprateModel(model, cf.floatTimes(), cf.floatWeights(), cf.fixedTimes(), cf.annuityWeights(), modelTimes, useExpectedXY);
 	}
 
 	QGSwaprateModel::QGSwaprateModel(
@@ -99,15 +278,9 @@ namespace QuantLibAddin {
 		QuantLib::Date fixingDate = today + ((QuantLib::BigInteger)QuantLib::ClosestRounding(0)(fixingTime*365.0)); // assuming act/365 day counting
 		QuantLib::SwapCashFlows scf(swapIndex->underlyingSwap(fixingDate), discountCurve, true);        // assume continuous tenor spreads
 		// we need to roll out the model time grid for discretisation
-		QuantLib::Size numberOfRegularPoints = (QuantLib::Size) (fixingTime * timePointsPerYear);  // this is rounded to the lower integer
-		std::vector<QuantLib::Time> modelTimes(numberOfRegularPoints + 1);
-		modelTimes[0] = 0.0;
-		for (QuantLib::Size k = 1; k < numberOfRegularPoints + 1; ++k) modelTimes[k] = modelTimes[k - 1] + 1.0 / timePointsPerYear;
-		if (modelTimes[numberOfRegularPoints]<fixingTime - 1.0 / 365.0) modelTimes.push_back(fixingTime);  // we want to avoid too close grid points
-		else modelTimes[numberOfRegularPoints] = fixingTime;
+		std::vector<QuantLib::Time> modelTimes = rollOutModelTimes(fixingTime, timePointsPerYear);
 		// finally, we may set up the model
-		libraryObject_ = boost::shared_ptr<QuantLib::QGSwaprateModel>(
-			new QuantLib::QGSwaprateModel(model, scf.floatTimes(), scf.floatWeights(), scf.fixedTimes(), scf.annuityWeights(), modelTimes, useExpectedXY));
+		libraryObject_ = cachedSwaprateModel(model, scf.floatTimes(), scf.floatWeights(), scf.fixedTimes(), scf.annuityWeights(), modelTimes, useExpectedXY);
 	}
 
 	QGAverageSwaprateModel::QGAverageSwaprateModel(
@@ -118,6 +291,85 @@ namespace QuantLibAddin {
 		libraryObject_ = boost::shared_ptr<QuantLib::QGAverageSwaprateModel>(new QuantLib::QGAverageSwaprateModel(model));
 	}
 
+	std::vector<QuantLib::Real> qgSwaprateModelCacheInfo() {
+		return swaprateModelCache().info();
+	}
+
+	QuantLib::Size qgSwaprateModelClearCache() {
+		return swaprateModelCache().clear();
+	}
+
+	std::vector< std::vector<QuantLib::Real> > quasiGaussianModelParameters(
+		const boost::shared_ptr<QuantLib::QuasiGaussianModel>&  model,
+		const std::vector<QuantLib::Time>&                      times) {
+		const std::vector<QuantLib::Time>& modelTimes = model->times();
+		const std::vector< std::vector<QuantLib::Real> >& sigma = model->sigma();
+		const std::vector< std::vector<QuantLib::Real> >& slope = model->slope();
+		const std::vector< std::vector<QuantLib::Real> >& curve = model->curve();
+		const std::vector<QuantLib::Real>& eta = model->eta();
+		QL_REQUIRE(modelTimes.size() > 0, "Non-empty model times required.");
+		QuantLib::Size d = sigma.size();
+		std::vector< std::vector<QuantLib::Real> > res(times.size(), std::vector<QuantLib::Real>(3 * d + 1, 0.0));
+		// walk the model grid once instead of searching it for each time; index
+		// convention follows the model, i.e. t in (T_k-1, T_k] maps to k, flat extrapolation
+		QuantLib::Size k = 0;
+		for (QuantLib::Size j = 0; j < times.size(); ++j) {
+			QL_REQUIRE(j == 0 || times[j] >= times[j - 1], "Times must be sorted ascending.");
+			while (k < modelTimes.size() - 1 && modelTimes[k] < times[j]) ++k;
+			for (QuantLib::Size i = 0; i < d; ++i) {
+				res[j][i]         = sigma[i][k];
+				res[j][d + i]     = slope[i][k];
+				res[j][2 * d + i] = curve[i][k];
+			}
+			res[j][3 * d] = eta[k];
+		}
+		return res;
+	}
+
+	std::vector< std::vector<QuantLib::Real> > qgCalibrationJacobian(
+		const boost::shared_ptr<QuantLib::QuasiGaussianModel>&          model,
+		const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&    swapIndices,
+		const QuantLib::Real                                            modelTimesStepSize,
+		const bool                                                      useExpectedXY,
+		const std::string&                                              parameter,
+		const QuantLib::Real                                            bumpSize) {
+		QL_REQUIRE(parameter == "sigma" || parameter == "slope" || parameter == "curve" || parameter == "eta",
+			"Parameter must be sigma, slope, curve or eta.");
+		QL_REQUIRE(bumpSize != 0.0, "Non-zero bump size required.");
+		QuantLib::Size timePointsPerYear = std::max((QuantLib::Size)1, (QuantLib::Size)(1.0 / modelTimesStepSize + 0.5));
+		const std::vector<QuantLib::Time>& times = model->times();
+		QuantLib::Size factors = (parameter == "eta") ? 1 : model->sigma().size();
+		std::vector<QuantLib::Real> basePrices = atmModelPrices(model, swapIndices, timePointsPerYear, useExpectedXY, 0.0, true);
+		std::vector< std::vector<QuantLib::Real> > jacobian(basePrices.size(), std::vector<QuantLib::Real>(factors * times.size(), 0.0));
+		for (QuantLib::Size j = 0; j < factors; ++j) {
+			for (QuantLib::Size l = 0; l < times.size(); ++l) {
+				std::vector< std::vector<QuantLib::Real> > sigma = model->sigma();
+				std::vector< std::vector<QuantLib::Real> > slope = model->slope();
+				std::vector< std::vector<QuantLib::Real> > curve = model->curve();
+				std::vector<QuantLib::Real> eta = model->eta();
+				if (parameter == "sigma") sigma[j][l] += bumpSize;
+				if (parameter == "slope") slope[j][l] += bumpSize;
+				if (parameter == "curve") curve[j][l] += bumpSize;
+				if (parameter == "eta")   eta[l] += bumpSize;
+				boost::shared_ptr<QuantLib::QuasiGaussianModel> bumped(new QuantLib::QuasiGaussianModel(model->termStructure(),
+					model->factors(), times, sigma, slope, curve, eta, model->delta(), model->chi(), model->Gamma(), model->theta()));
+				// fixings up to the previous pillar do not see the bumped parameter
+				QuantLib::Time minTime = (l > 0) ? times[l - 1] : 0.0;
+				// bumped models are short-lived and bypass the swap rate model cache
+				std::vector<QuantLib::Real> prices = atmModelPrices(bumped, swapIndices, timePointsPerYear, useExpectedXY, minTime, false);
+				QuantLib::Size row = 0;
+				for (QuantLib::Size i = 0; i < swapIndices.size(); ++i) {
+					for (QuantLib::Size k = 0; k < times.size(); ++k) {
+						if (times[k] <= 0.0) continue;
+						if (times[k] > minTime) jacobian[row][j * times.size() + l] = (prices[row] - basePrices[row]) / bumpSize;
+						++row;
+					}
+				}
+			}
+		}
+		return jacobian;
+	}
+
 	QGCalibrator::QGCalibrator(
 		const boost::shared_ptr<ObjectHandler::ValueObject>&            properties,
 		const boost::shared_ptr<QuantLib::QuasiGaussianModel>&          model,
@@ -135,10 +387,62 @@ namespace QuantLibAddin {
 		const QuantLib::Real                                            penaltySlope,
 		const boost::shared_ptr<QuantLib::EndCriteria>&                 endCriteria,
 		bool                                                            permanent)
-		: ObjectHandler::LibraryObject<QuantLib::QGCalibrator>(properties, permanent) {
+		: ObjectHandler::LibraryObject<QuantLib::QGCalibrator>(properties, permanent), bestStart_(0) {
+		boost::timer t;
 		libraryObject_ = boost::shared_ptr<QuantLib::QGCalibrator>(
 			new QuantLib::QGCalibrator(model, volTS, swapIndices, modelTimesStepSize, useExpectedXY, 
 				sigmaMax, slopeMax, etaMax, sigmaWeight, slopeWeight, etaWeight, penaltySigma, penaltySlope, endCriteria));
+		calibrationTime_ = t.elapsed();
+	}
+
+	QGCalibrator::QGCalibrator(
+		const boost::shared_ptr<ObjectHandler::ValueObject>&                     properties,
+		const std::vector< boost::shared_ptr<QuantLib::QuasiGaussianModel> >&    startModels,
+		const QuantLib::Handle<QuantLib::SwaptionVolatilityStructure>&           volTS,
+		const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&             swapIndices,
+		const QuantLib::Real                                                     modelTimesStepSize,
+		const bool                                                               useExpectedXY,
+		const QuantLib::Real                                                     sigmaMax,
+		const QuantLib::Real                                                     slopeMax,
+		const QuantLib::Real                                                     etaMax,
+		const QuantLib::Real                                                     sigmaWeight,
+		const QuantLib::Real                                                     slopeWeight,
+		const QuantLib::Real                                                     etaWeight,
+		const QuantLib::Real                                                     penaltySigma,
+		const QuantLib::Real                                                     penaltySlope,
+		const boost::shared_ptr<QuantLib::EndCriteria>&                          endCriteria,
+		bool                                                                     permanent)
+		: ObjectHandler::LibraryObject<QuantLib::QGCalibrator>(properties, permanent), bestStart_(0) {
+		QL_REQUIRE(startModels.size() > 0, "QGCalibrator: start models required.");
+		boost::timer total, t;
+		for (QuantLib::Size k = 0; k < startModels.size(); ++k) {
+			t.restart();
+			boost::shared_ptr<QuantLib::QGCalibrator> calibrator(
+				new QuantLib::QGCalibrator(startModels[k], volTS, swapIndices, modelTimesStepSize, useExpectedXY,
+					sigmaMax, slopeMax, etaMax, sigmaWeight, slopeWeight, etaWeight, penaltySigma, penaltySlope, endCriteria));
+			QL_REQUIRE(calibrator->calibratedModel(), "Non-empty model pointer required.");
+			startErrors_.push_back(calibrationObjective(calibrator->calibratedModel(), volTS, swapIndices, modelTimesStepSize, useExpectedXY,
+				sigmaWeight, slopeWeight, etaWeight, penaltySigma, penaltySlope));
+			startTimes_.push_back(t.elapsed());
+			if (k == 0 || startErrors_[k] < startErrors_[bestStart_]) {
+				bestStart_ = k;
+				libraryObject_ = calibrator;
+			}
+		}
+		calibrationTime_ = total.elapsed();
+	}
+
+	std::vector<std::string> QGCalibrator::debugLog() const {
+		std::vector<std::string> log = libraryObject_->debugLog();
+		for (QuantLib::Size k = 0; k < startErrors_.size(); ++k) {
+			std::ostringstream line;
+			line << "Start " << k << ": objective " << startErrors_[k] << ", time " << startTimes_[k] << "s" << ((k == bestStart_) ? " (best)" : "");
+			log.push_back(line.str());
+		}
+		std::ostringstream line;
+		line << "Calibration time " << calibrationTime_ << "s";
+		log.push_back(line.str());
+		return log;
 	}
 
 	// calibrated model from calibrator
@@ -169,10 +473,20 @@ namespace QuantLibAddin {
 		const QuantLib::Real                                            penaltyCurve,
 		const boost::shared_ptr<QuantLib::EndCriteria>&                 endCriteria,
 		bool                                                            permanent)
-		: ObjectHandler::LibraryObject<QuantLib::QGMonteCarloCalibrator>(properties, permanent) {
+		: ObjectHandler::LibraryObject<QuantLib::QGMonteCarloCalibrator>(properties, permanent), monteCarloPaths_(monteCarloPaths) {
+		boost::timer t;
 		libraryObject_ = boost::shared_ptr<QuantLib::QGMonteCarloCalibrator>(
 			new QuantLib::QGMonteCarloCalibrator(model, volTS, swapIndices, monteCarloStepSize, monteCarloPaths,
 				sigmaMax, slopeMax, curveMax, sigmaWeight, slopeWeight, curveWeight, penaltySigma, penaltySlope, penaltyCurve, endCriteria));
+		calibrationTime_ = t.elapsed();
+	}
+
+	std::vector<std::string> QGMonteCarloCalibrator::debugLog() const {
+		std::vector<std::string> log = libraryObject_->debugLog();
+		std::ostringstream line;
+		line << "Calibration time " << calibrationTime_ << "s with " << monteCarloPaths_ << " paths";
+		log.push_back(line.str());
+		return log;
 	}
 
 	// calibrated model from calibrator
@@ -231,6 +545,7 @@ namespace QuantLibAddin {
 		else {
 			QL_REQUIRE(0, "Invalid flavor parameter");
 		}
+		calibrationTime_ = 0.0;
 	}
 
 	QGLocalvolModel::QGLocalvolModel(
@@ -252,15 +567,61 @@ namespace QuantLibAddin {
 		bool                                                            permanent)
 		: QuasiGaussianModel(properties, permanent) {
 		libraryObject_ = boost::shared_ptr<QuantLib::QuasiGaussianModel>(new QuantLib::QGLSVModel(hYTS, volTS, chi, theta, eta, swapIndex, times, nStrikes, calcStochVolAdjustment, kernelWidth, svKernelScaling, nPaths, seed, debugLevel));
+		calibrationTime_ = 0.0;
+	}
+
+	boost::shared_ptr<QuantLib::QGLocalvolModel> QGLocalvolModel::localvolModel() const {
+		boost::shared_ptr<QuantLib::QGLocalvolModel> model = boost::dynamic_pointer_cast<QuantLib::QGLocalvolModel>(libraryObject_);
+		QL_REQUIRE(model, "QGLocalvolModel required.");
+		return model;
+	}
+
+	void QGLocalvolModel::simulateAndCalibrate() {
+		boost::timer t;
+		localvolModel()->simulateAndCalibrate();
+		calibrationTime_ = t.elapsed();
+	}
+
+	std::vector<std::string> QGLocalvolModel::debugLog() const {
+		std::vector<std::string> log = localvolModel()->debugLog();
+		std::ostringstream line;
+		line << "Calibration time " << calibrationTime_ << "s";
+		log.push_back(line.str());
+		return log;
+	}
+
+	std::vector< std::vector<QuantLib::Real> > QGLocalvolModel::sigmaSTable(const std::vector<QuantLib::Size>& idx,
+		                                                                    const std::vector<QuantLib::Real>& S) const {
+		boost::shared_ptr<QuantLib::QGLocalvolModel> model = localvolModel();
+		std::vector< std::vector<QuantLib::Real> > table(idx.size(), std::vector<QuantLib::Real>(S.size()));
+		for (QuantLib::Size i = 0; i < idx.size(); ++i)
+			for (QuantLib::Size j = 0; j < S.size(); ++j) table[i][j] = model->sigmaS(idx[i], S[j]);
+		return table;
 	}
 
 	QGLocalvolModelSimulation::QGLocalvolModelSimulation(
 		const boost::shared_ptr<ObjectHandler::ValueObject>&         properties,
 		const boost::shared_ptr<QuantLib::QGLocalvolModel>&          model,
+		const QuantLib::BigNatural                                   seed,
+		const QuantLib::Size                                         nPaths,
+		const bool                                                   richardsonExtrapolation,
+		const bool                                                   timeInterpolation,
+		const bool                                                   storeBrownians,
 		bool                                                         permanent)
 		: RealMCSimulation(properties, permanent) {
 		QL_REQUIRE(model->simulation(), "Non-empty simulation pointer required.");
-		libraryObject_ = boost::shared_ptr<QuantLib::QGLocalvolModel::MCSimulation>(model->simulation());
+		if (seed == 0) {
+			QL_REQUIRE(nPaths == 0 || nPaths == model->simulation()->nPaths(), "Calibration paths can only be reused with their number of paths.");
+			libraryObject_ = boost::shared_ptr<QuantLib::QGLocalvolModel::MCSimulation>(model->simulation());
+			return;
+		}
+		// re-simulation uses the grids of the calibration paths and the given discretisation flags
+		boost::shared_ptr<QuantLib::QGLocalvolModel::MCSimulation> calibration = model->simulation();
+		boost::shared_ptr<QuantLib::RealMCSimulation> simulation(new QuantLib::RealMCSimulation(model,
+			calibration->simTimes(), calibration->obsTimes(), (nPaths > 0) ? nPaths : calibration->nPaths(), seed,
+			richardsonExtrapolation, timeInterpolation, storeBrownians));
+		simulation->simulate();
+		libraryObject_ = simulation;
 	}
 
 
@@ -112,6 +112,31 @@ namespace QuantLibAddin {
 			bool                                                                            permanent);
 	};
 
+	// swap rate models are memoized by model parameter values, schedule and discount factors;
+	// returns number of entries, hits and misses
+	std::vector<QuantLib::Real> qgSwaprateModelCacheInfo();
+
+	// returns number of removed entries
+	QuantLib::Size qgSwaprateModelClearCache();
+
+	// piecewise-constant model parameters on a sorted vector of times; rows are times,
+	// columns are sigma, slope and curve per factor followed by eta
+	std::vector< std::vector<QuantLib::Real> > quasiGaussianModelParameters(
+		const boost::shared_ptr<QuantLib::QuasiGaussianModel>&  model,
+		const std::vector<QuantLib::Time>&                      times);
+
+	// forward difference sensitivities of averaged swap rate model ATM prices (rows per swap
+	// index and model time) w.r.t. parameter pillars ("sigma", "slope", "curve" per factor and
+	// time, or "eta" per time); parameters are left-constant, so a pillar only affects later
+	// fixings and earlier rows are not re-evaluated
+	std::vector< std::vector<QuantLib::Real> > qgCalibrationJacobian(
+		const boost::shared_ptr<QuantLib::QuasiGaussianModel>&          model,
+		const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&    swapIndices,
+		const QuantLib::Real                                            modelTimesStepSize,
+		const bool                                                      useExpectedXY,
+		const std::string&                                              parameter,
+		const QuantLib::Real                                            bumpSize);
+
 	class QGCalibrator : public ObjectHandler::LibraryObject<QuantLib::QGCalibrator> {
 	public:
 		QGCalibrator(const boost::shared_ptr<ObjectHandler::ValueObject>&            properties,
@@ -130,6 +155,36 @@ namespace QuantLibAddin {
 			         const QuantLib::Real                                            penaltySlope,
 			         const boost::shared_ptr<QuantLib::EndCriteria>&                 endCriteria,
 			         bool                                                            permanent);
+
+		// multi-start calibration; each start model is calibrated and the result with the
+		// smallest weighted objective (ATM, skew, curvature and multi-factor penalties) is kept
+		QGCalibrator(const boost::shared_ptr<ObjectHandler::ValueObject>&                     properties,
+			         const std::vector< boost::shared_ptr<QuantLib::QuasiGaussianModel> >&    startModels,
+			         const QuantLib::Handle<QuantLib::SwaptionVolatilityStructure>&           volTS,
+			         const std::vector< boost::shared_ptr<QuantLib::SwapIndex> >&             swapIndices,
+			         const QuantLib::Real                                                     modelTimesStepSize,
+			         const bool                                                               useExpectedXY,
+                     const QuantLib::Real                                                     sigmaMax,
+                     const QuantLib::Real                                                     slopeMax,
+                     const QuantLib::Real                                                     etaMax,
+                     const QuantLib::Real                                                     sigmaWeight,
+                     const QuantLib::Real                                                     slopeWeight,
+                     const QuantLib::Real                                                     etaWeight,
+			         const QuantLib::Real                                                     penaltySigma,
+			         const QuantLib::Real                                                     penaltySlope,
+			         const boost::shared_ptr<QuantLib::EndCriteria>&                          endCriteria,
+			         bool                                                                     permanent);
+
+		// library debug log extended by timing and multi-start summary
+		std::vector<std::string> debugLog() const;
+		QuantLib::Real calibrationTime() const { return calibrationTime_; }
+		const std::vector<QuantLib::Real>& startErrors() const { return startErrors_; }
+		QuantLib::Size bestStart() const { return bestStart_; }
+	protected:
+		std::vector<QuantLib::Real>  startErrors_;
+		std::vector<QuantLib::Real>  startTimes_;
+		QuantLib::Size               bestStart_;
+		QuantLib::Real               calibrationTime_;
 	};
 
 	class QGMonteCarloCalibrator : public ObjectHandler::LibraryObject<QuantLib::QGMonteCarloCalibrator> {
@@ -152,6 +207,13 @@ namespace QuantLibAddin {
 			const QuantLib::Real                                            penaltyCurve,
 			const boost::shared_ptr<QuantLib::EndCriteria>&                 endCriteria,
 			bool                                                            permanent);
+
+		// library debug log extended by timing
+		std::vector<std::string> debugLog() const;
+		QuantLib::Real calibrationTime() const { return calibrationTime_; }
+	protected:
+		QuantLib::Size               monteCarloPaths_;
+		QuantLib::Real               calibrationTime_;
 	};
 
 	class QGLocalvolModel : public QuasiGaussianModel {
@@ -191,13 +253,32 @@ namespace QuantLibAddin {
 			const QuantLib::Size                                            debugLevel,
 			bool                                                            permanent);
 
+		// timed calibration and library debug log extended by timing
+		void simulateAndCalibrate();
+		std::vector<std::string> debugLog() const;
+		QuantLib::Real calibrationTime() const { return calibrationTime_; }
+		// local volatility for all combinations of time grid indices (rows) and underlyings (columns)
+		std::vector< std::vector<QuantLib::Real> > sigmaSTable(const std::vector<QuantLib::Size>& idx,
+			                                                   const std::vector<QuantLib::Real>& S) const;
+	protected:
+		boost::shared_ptr<QuantLib::QGLocalvolModel> localvolModel() const;
+		QuantLib::Real calibrationTime_;
 	};
 
 	class QGLocalvolModelSimulation : public RealMCSimulation {
 	public:
+		// seed zero hands over the calibration paths without copying; otherwise the model is
+		// re-simulated on the calibration grid with an independent seed (and optionally
+		// a different number of paths, zero keeps the calibration number) using the given
+		// discretisation flags, which are ignored when the calibration paths are reused
 		QGLocalvolModelSimulation(
 			const boost::shared_ptr<ObjectHandler::ValueObject>&         properties,
 			const boost::shared_ptr<QuantLib::QGLocalvolModel>&          model,
+			const QuantLib::BigNatural                                   seed,
+			const QuantLib::Size                                         nPaths,
+			const bool                                                   richardsonExtrapolation,
+			const bool                                                   timeInterpolation,
+			const bool                                                   storeBrownians,
 			bool                                                         permanent);
 	};
 